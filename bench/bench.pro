@@ -0,0 +1,20 @@
+# -------------------------------------------------
+# Benchmarks, not installed
+# -------------------------------------------------
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = qactus-bench
+TEMPLATE = app
+DEPENDPATH += . ..
+INCLUDEPATH += . ..
+DESTDIR += .
+SOURCES += main.cpp \
+    legacyreader.cpp \
+    ../obsxmlreader.cpp \
+    ../obspackage.cpp \
+    ../obsrequest.cpp \
+    ../obsprojectmeta.cpp \
+    ../obslistindex.cpp \
+    ../obssearchindex.cpp
+HEADERS += legacyreader.h \
+    ../obssearchindex.h
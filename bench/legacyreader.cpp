@@ -0,0 +1,121 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "legacyreader.h"
+
+LegacyReader::LegacyReader()
+{
+    obsRequest = NULL;
+}
+
+LegacyReader::~LegacyReader()
+{
+    qDeleteAll(obsRequests);
+}
+
+QList<LegacyRequest*> LegacyReader::takeRequests()
+{
+    QList<LegacyRequest*> requests = obsRequests;
+    obsRequests.clear();
+    return requests;
+}
+
+void LegacyReader::addData(const QByteArray &data)
+{
+//    The reply used to be converted to a QString, scanned for the root
+//    element, and then parsed again from the start by parseRequests()
+    QString stringData = data;
+    QXmlStreamReader xml(stringData);
+
+    while (!xml.atEnd() && !xml.hasError()) {
+        xml.readNext();
+        if (xml.name()=="collection" && xml.isStartElement()) {
+            parseRequests(stringData);
+        }
+    }
+}
+
+void LegacyReader::parseRequests(const QString &data)
+{
+    QXmlStreamReader xml(data);
+    qDeleteAll(obsRequests);
+    obsRequests.clear();
+
+    while (!xml.atEnd() && !xml.hasError()) {
+        xml.readNext();
+
+        if (xml.name()=="collection") {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                requestNumber = attrib.value("matches").toString();
+            }
+        } // collection
+
+        if (xml.name()=="request") {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                obsRequest = new LegacyRequest;
+                obsRequest->id = attrib.value("id").toString();
+            }
+        }
+
+        if (xml.name()=="action")  {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                obsRequest->actionType = attrib.value("type").toString();
+            }
+        } // action
+
+        if (xml.name()=="source") {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                obsRequest->sourceProject = attrib.value("project").toString();
+                obsRequest->sourcePackage = attrib.value("package").toString();
+            }
+        } // source
+
+        if (xml.name()=="target") {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                obsRequest->targetProject = attrib.value("project").toString();
+                obsRequest->targetPackage = attrib.value("package").toString();
+            }
+        } // target
+
+        if (xml.name()=="state") {
+            if (xml.isStartElement()) {
+                QXmlStreamAttributes attrib = xml.attributes();
+                obsRequest->state = attrib.value("name").toString();
+                obsRequest->requester = attrib.value("who").toString();
+                obsRequest->date = attrib.value("when").toString();
+            }
+        } // state
+
+        if (xml.name()=="description") {
+            if (xml.tokenType() != QXmlStreamReader::StartElement) {
+                return;
+            }
+            xml.readNext();
+            obsRequest->description = xml.text().toString();
+            xml.readNextStartElement();
+            obsRequests.append(obsRequest);
+        } // description
+    }
+}
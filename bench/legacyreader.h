@@ -0,0 +1,67 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef LEGACYREADER_H
+#define LEGACYREADER_H
+
+#include <QString>
+#include <QList>
+#include <QByteArray>
+#include <QXmlStreamReader>
+
+/*
+ * The old request parser, kept as the baseline of the benchmarks: the
+ * whole reply is converted to a QString, scanned for the root element
+ * and then parsed again from the start, with a new LegacyRequest per
+ * request. LegacyRequest is the old request class, ten separate strings
+ * per request on the heap. Only the qDebug() calls have been left out.
+ *
+ */
+class LegacyRequest
+{
+public:
+    QString id;
+    QString actionType;
+    QString sourceProject;
+    QString sourcePackage;
+    QString targetProject;
+    QString targetPackage;
+    QString state;
+    QString requester;
+    QString date;
+    QString description;
+};
+
+class LegacyReader
+{
+public:
+    LegacyReader();
+    ~LegacyReader();
+    void addData(const QByteArray &data);
+    QList<LegacyRequest*> takeRequests();
+
+private:
+    void parseRequests(const QString &data);
+    QList<LegacyRequest*> obsRequests;
+    LegacyRequest *obsRequest;
+    QString requestNumber;
+};
+
+#endif // LEGACYREADER_H
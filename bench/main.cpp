@@ -0,0 +1,285 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include "legacyreader.h"
+#include "obsxmlreader.h"
+#include "obslistindex.h"
+#include "obssearchindex.h"
+#ifdef Q_OS_LINUX
+#include <malloc.h>
+#endif
+
+static const int parseRuns = 5;
+static const int memoryRequests = 10000;
+static const int searchNames = 100000;
+static const int maxSearchTime = 10;
+
+#if QT_VERSION >= 0x050000
+static void silentMessageHandler(QtMsgType type, const QMessageLogContext &, const QString &)
+#else
+static void silentMessageHandler(QtMsgType type, const char *)
+#endif
+{
+//    The parsers log every request, which would be timed too
+    if (type == QtFatalMsg) {
+        abort();
+    }
+}
+
+static qint64 heapUsed()
+{
+#ifdef Q_OS_LINUX
+    return mallinfo().uordblks;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Builds a request collection the size of a busy user's one, about
+ * 5 MB with the default number of requests
+ *
+ */
+static QByteArray createCollection(int requests)
+{
+    QByteArray data;
+    data.reserve(requests * 900);
+    data += "<collection matches=\"" + QByteArray::number(requests) + "\">\n";
+
+    for (int i = 0; i < requests; i++) {
+        QByteArray id = QByteArray::number(100000 + i);
+        QByteArray project = "home:user" + QByteArray::number(i % 50);
+        QByteArray package = "package" + QByteArray::number(i % 700);
+        data += "  <request id=\"" + id + "\">\n"
+                "    <action type=\"submit\">\n"
+                "      <source project=\"" + project + "\" package=\"" + package + "\" rev=\"" + id + "\"/>\n"
+                "      <target project=\"openSUSE:Factory\" package=\"" + package + "\"/>\n"
+                "    </action>\n"
+                "    <state name=\"review\" who=\"user" + QByteArray::number(i % 50) + "\" when=\"2015-06-01T10:00:00\">\n"
+                "      <comment>Please review the changes of " + package + "</comment>\n"
+                "    </state>\n"
+                "    <review state=\"new\" by_group=\"factory-staging\"/>\n"
+                "    <history who=\"user" + QByteArray::number(i % 50) + "\" when=\"2015-06-01T09:00:00\">\n"
+                "      <description>Request created</description>\n"
+                "    </history>\n"
+                "    <description>- Update to version 1." + QByteArray::number(i % 10) + "\n"
+                "  * Fix the build with the new toolchain\n"
+                "  * Drop the patches merged upstream\n"
+                "  * Refresh the spec file and the changes file</description>\n"
+                "  </request>\n";
+    }
+    data += "</collection>\n";
+    return data;
+}
+
+/*
+ * Project names shaped like the ones of build.opensuse.org
+ *
+ */
+static QStringList createNames(int count)
+{
+    static const char* const areas[] = {
+        "devel:languages:python", "devel:languages:perl", "devel:tools",
+        "KDE", "GNOME", "server:database", "science", "games"
+    };
+    QStringList names;
+    for (int i = 0; i < count; i++) {
+//        Every area shows up in each kind of name
+        const char *area = areas[(i / 4) % 8];
+        QString user = "home:user" + QString::number(i % 20000);
+        switch (i % 4) {
+        case 0:
+            names.append(user);
+            break;
+        case 1:
+            names.append(user + ":branches:" + area + ":Factory");
+            break;
+        case 2:
+            names.append(QString(area) + ":" + QString::number(i));
+            break;
+        default:
+            names.append(user + ":test" + QString::number(i));
+            break;
+        }
+    }
+    return names;
+}
+
+/*
+ * Times the request parser against the old one
+ *
+ */
+static bool benchParse(QTextStream &out, int requests)
+{
+    QByteArray data = createCollection(requests);
+    QElapsedTimer timer;
+    qint64 legacyTime = -1;
+    int legacyCount = 0;
+    for (int i = 0; i < parseRuns; i++) {
+        LegacyReader legacyReader;
+        timer.start();
+        legacyReader.addData(data);
+        QList<LegacyRequest*> legacyRequests = legacyReader.takeRequests();
+        qint64 elapsed = timer.elapsed();
+        legacyCount = legacyRequests.size();
+        qDeleteAll(legacyRequests);
+        if (legacyTime < 0 || elapsed < legacyTime) {
+            legacyTime = elapsed;
+        }
+    }
+
+    qint64 newTime = -1;
+    int newCount = 0;
+    for (int i = 0; i < parseRuns; i++) {
+        timer.start();
+        OBSxmlReader *xmlReader = OBSxmlReader::parseData(data);
+        QVector<OBSrequest> newRequests = xmlReader->getRequests();
+        qint64 elapsed = timer.elapsed();
+        newCount = newRequests.size();
+        delete xmlReader;
+        if (newTime < 0 || elapsed < newTime) {
+            newTime = elapsed;
+        }
+    }
+
+    out << "Collection: " << data.size() << " bytes, " << requests << " requests" << endl;
+    out << "Legacy parser: " << legacyTime << " ms, " << legacyCount << " requests (best of "
+        << parseRuns << ")" << endl;
+    out << "OBSxmlReader: " << newTime << " ms, " << newCount << " requests (best of "
+        << parseRuns << ")" << endl;
+    return true;
+}
+
+/*
+ * Heap kept by the requests of a collection once it has been parsed
+ *
+ */
+static bool benchMemory(QTextStream &out)
+{
+    QByteArray data = createCollection(memoryRequests);
+    qint64 heapBefore = heapUsed();
+    if (heapBefore < 0) {
+        out << "Memory: not measured on this platform" << endl;
+        return true;
+    }
+
+    LegacyReader *legacyReader = new LegacyReader();
+    legacyReader->addData(data);
+    QList<LegacyRequest*> legacyRequests = legacyReader->takeRequests();
+    delete legacyReader;
+    qint64 legacyHeap = heapUsed() - heapBefore;
+    qDeleteAll(legacyRequests);
+    legacyRequests.clear();
+
+    heapBefore = heapUsed();
+    OBSxmlReader *xmlReader = OBSxmlReader::parseData(data);
+    QVector<OBSrequest> obsRequests = xmlReader->getRequests();
+    delete xmlReader;
+    qint64 newHeap = heapUsed() - heapBefore;
+    int count = obsRequests.size();
+    obsRequests.clear();
+
+    out << "Memory of " << count << " requests: legacy " << legacyHeap / 1024
+        << " KB, OBSrequest " << newHeap / 1024 << " KB" << endl;
+    return true;
+}
+
+/*
+ * Completion has to keep up with typing
+ *
+ */
+static bool benchSearch(QTextStream &out)
+{
+    QString indexFileName = "names.idx";
+    OBSlistIndex::build(indexFileName, createNames(searchNames));
+    OBSsearchIndex searchIndex;
+    QEventLoop loop;
+    QObject::connect(&searchIndex, SIGNAL(ready()), &loop, SLOT(quit()));
+    searchIndex.build(indexFileName);
+    loop.exec();
+
+    QStringList queries;
+    queries << "h" << "home:user1" << "python:Fac" << "pyhton" << "branches:games"
+            << "database:12" << "test99";
+    QStringList searchTimes;
+    QElapsedTimer timer;
+    double maxTime = 0;
+    foreach (const QString &query, queries) {
+        timer.start();
+        searchIndex.search(query);
+        double elapsed = timer.nsecsElapsed() / 1000000.0;
+        maxTime = qMax(maxTime, elapsed);
+        searchTimes.append(query + " " + QString::number(elapsed, 'f', 2) + " ms");
+    }
+    bool typoFound = !searchIndex.search("pyhton").filter("python").isEmpty();
+    QFile::remove(QDir(OBSxmlReader::getDataDir()).filePath(indexFileName));
+
+    out << "Search in " << searchNames << " names: " << searchTimes.join(", ") << endl;
+    out << "Slowest search: " << QString::number(maxTime, 'f', 2) << " ms ("
+        << (maxTime < maxSearchTime ? "OK" : "too slow") << ", limit "
+        << maxSearchTime << " ms)" << endl;
+    out << "Search with a typo: pyhton " << (typoFound ? "finds python" : "misses python") << endl;
+    return maxTime < maxSearchTime && typoFound;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+//    The index is written to the data directory, away from Qactus' one
+    app.setApplicationName("qactus-bench");
+    QTextStream out(stdout);
+
+//    qactus-bench [parse|memory|search] [requests]
+    QStringList arguments = app.arguments().mid(1);
+    QString benchmark;
+    if (!arguments.isEmpty() && (arguments.first() == "parse" ||
+                                 arguments.first() == "memory" || arguments.first() == "search")) {
+        benchmark = arguments.takeFirst();
+    }
+    int requests = 5800;
+    if (!arguments.isEmpty()) {
+        requests = arguments.first().toInt();
+    }
+
+#if QT_VERSION >= 0x050000
+    qInstallMessageHandler(silentMessageHandler);
+#else
+    qInstallMsgHandler(silentMessageHandler);
+#endif
+
+//    A single benchmark exits with its own result, all of them
+//    together only report their numbers
+    if (benchmark == "parse") {
+        return benchParse(out, requests) ? 0 : 1;
+    } else if (benchmark == "memory") {
+        return benchMemory(out) ? 0 : 1;
+    } else if (benchmark == "search") {
+        return benchSearch(out) ? 0 : 1;
+    }
+    benchParse(out, requests);
+    benchMemory(out);
+    benchSearch(out);
+    return 0;
+}
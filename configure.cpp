@@ -28,7 +28,11 @@ Configure::Configure(QWidget *parent) :
     ui->setupUi(this);
 
     createTimer();
-    connect(timer, SIGNAL(timeout()), parent, SLOT(refreshView()));
+    batchedRefresh = ui->checkBox_Batched->isChecked();
+    watchMode = ui->checkBox_Watch->isChecked();
+    requestsPerSecond = ui->doubleSpinBox_Rate->value();
+    burstSize = ui->spinBox_Burst->value();
+    maxConnections = ui->spinBox_Connections->value();
 }
 
 Configure::~Configure()
@@ -38,7 +42,9 @@ Configure::~Configure()
 
 void Configure::createTimer()
 {
-    timer = new QTimer(this);
+//    The polling itself is done by MainWindow's PollScheduler,
+//    the spinbox sets the interval used for rows with no specific one
+    timerActive = false;
 
     ui->spinBox->setMinimum(5);
     ui->spinBox->setMaximum(1440);
@@ -47,34 +53,43 @@ void Configure::createTimer()
     connect(ui->checkBox_Timer, SIGNAL(toggled(bool)), ui->spinBox, SLOT(setEnabled(bool)));
 
 }
-void Configure::startTimer(const int& interval)
-{
-    qDebug() << "startTimer()";
-    timer->start(interval);
-}
 
 void Configure::on_buttonBox_accepted()
 {
-    if (ui->checkBox_Timer->isChecked()) {
-//        Start the timer if the checkbox is checked
-//        and convert mins into msecs
-        timer->start(ui->spinBox->value()*60000);
-        qDebug() << "Timer set to" << ui->spinBox->value() << "minutes";
+    batchedRefresh = ui->checkBox_Batched->isChecked();
+    if (watchMode != ui->checkBox_Watch->isChecked()) {
+        watchMode = ui->checkBox_Watch->isChecked();
+        emit watchModeChanged(watchMode);
+    }
 
-    } else if (timer->isActive()) {
-        timer->stop();
-        qDebug() << "The timer has been stopped";
+    if (requestsPerSecond != ui->doubleSpinBox_Rate->value() ||
+            burstSize != ui->spinBox_Burst->value() ||
+            maxConnections != ui->spinBox_Connections->value()) {
+        requestsPerSecond = ui->doubleSpinBox_Rate->value();
+        burstSize = ui->spinBox_Burst->value();
+        maxConnections = ui->spinBox_Connections->value();
+        emit rateLimitsChanged();
     }
+
+    timerActive = ui->checkBox_Timer->isChecked();
+    qDebug() << "Timer active:" << timerActive << "Default interval:"
+             << ui->spinBox->value() << "minutes";
+    emit timerChanged();
 }
 
 void Configure::on_buttonBox_rejected()
 {
-    ui->checkBox_Timer->setChecked(timer->isActive());
+    ui->checkBox_Timer->setChecked(timerActive);
+    ui->checkBox_Batched->setChecked(batchedRefresh);
+    ui->checkBox_Watch->setChecked(watchMode);
+    ui->doubleSpinBox_Rate->setValue(requestsPerSecond);
+    ui->spinBox_Burst->setValue(burstSize);
+    ui->spinBox_Connections->setValue(maxConnections);
 }
 
 bool Configure::isTimerActive()
 {
-    return timer->isActive();
+    return timerActive;
 }
 
 int Configure::getTimerValue()
@@ -91,4 +106,58 @@ void Configure::setTimerValue(const int& value)
 void Configure::setCheckedTimerCheckbox(bool check)
 {
     ui->checkBox_Timer->setChecked(check);
+    timerActive = check;
+}
+
+bool Configure::isBatchedRefresh()
+{
+    return batchedRefresh;
+}
+
+void Configure::setCheckedBatchedCheckbox(bool check)
+{
+    ui->checkBox_Batched->setChecked(check);
+    batchedRefresh = check;
+}
+
+bool Configure::isWatchMode()
+{
+    return watchMode;
+}
+
+void Configure::setCheckedWatchCheckbox(bool check)
+{
+    ui->checkBox_Watch->setChecked(check);
+    watchMode = check;
+}
+
+void Configure::setRateLimits(double requestsPerSecond, int burstSize, int maxConnections)
+{
+    ui->doubleSpinBox_Rate->setValue(requestsPerSecond);
+    ui->spinBox_Burst->setValue(burstSize);
+    ui->spinBox_Connections->setValue(maxConnections);
+//    The spinboxes clamp the values
+    this->requestsPerSecond = ui->doubleSpinBox_Rate->value();
+    this->burstSize = ui->spinBox_Burst->value();
+    this->maxConnections = ui->spinBox_Connections->value();
+}
+
+double Configure::getRequestsPerSecond()
+{
+    return requestsPerSecond;
+}
+
+int Configure::getBurstSize()
+{
+    return burstSize;
+}
+
+int Configure::getMaxConnections()
+{
+    return maxConnections;
+}
+
+void Configure::setQueueStats(const QString &stats)
+{
+    ui->label_QueueStats->setText(stats);
 }
@@ -24,7 +24,6 @@
 #include <QDialog>
 #include <QDebug>
 #include <QCheckBox>
-#include <QTimer>
 #include <QSpinBox>
 
 namespace Ui {
@@ -39,11 +38,24 @@ public:
     explicit Configure(QWidget *parent = 0);
     ~Configure();
 
-    void startTimer(const int&);
     void setTimerValue(const int&);
     int getTimerValue();
     bool isTimerActive();
     void setCheckedTimerCheckbox(bool);
+    bool isBatchedRefresh();
+    void setCheckedBatchedCheckbox(bool);
+    bool isWatchMode();
+    void setCheckedWatchCheckbox(bool);
+    void setRateLimits(double requestsPerSecond, int burstSize, int maxConnections);
+    double getRequestsPerSecond();
+    int getBurstSize();
+    int getMaxConnections();
+    void setQueueStats(const QString &stats);
+
+signals:
+    void watchModeChanged(bool);
+    void timerChanged();
+    void rateLimitsChanged();
 
 private slots:
     void on_buttonBox_accepted();
@@ -51,8 +63,13 @@ private slots:
 
 private:
     Ui::Configure *ui;
-    QTimer *timer;
     void createTimer();
+    bool timerActive;
+    bool batchedRefresh;
+    bool watchMode;
+    double requestsPerSecond;
+    int burstSize;
+    int maxConnections;
 };
 
 #endif // CONFIGURE_H
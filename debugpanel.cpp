@@ -0,0 +1,88 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "debugpanel.h"
+#include "ui_debugpanel.h"
+
+DebugPanel::DebugPanel(QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DebugPanel)
+{
+    ui->setupUi(this);
+
+    QFont font("Monospace");
+    font.setStyleHint(QFont::TypeWriter);
+    ui->plainTextEdit->setFont(font);
+}
+
+DebugPanel::~DebugPanel()
+{
+    delete ui;
+}
+
+void DebugPanel::refresh()
+{
+//    The counters and timings of every server, as recorded by its OBSaccess
+    QStringList text;
+    foreach (OBSaccess *obsAccess, OBSaccess::getInstances()) {
+        text << obsAccess->getApiUrl();
+        text << obsAccess->getStatisticsReport();
+        text << obsAccess->getTimingsReport();
+        text << "";
+    }
+    ui->plainTextEdit->setPlainText(text.join("\n"));
+}
+
+void DebugPanel::on_pushButton_Refresh_clicked()
+{
+    refresh();
+}
+
+void DebugPanel::on_pushButton_Reset_clicked()
+{
+    foreach (OBSaccess *obsAccess, OBSaccess::getInstances()) {
+        obsAccess->clearTimings();
+    }
+    refresh();
+}
+
+void DebugPanel::on_pushButton_Save_clicked()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("Save network statistics"),
+                                                    QDir(OBSxmlReader::getDataDir()).filePath("timings.json"),
+                                                    tr("JSON files (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+//    One object per server, keyed by its API URL
+    QStringList servers;
+    foreach (OBSaccess *obsAccess, OBSaccess::getInstances()) {
+        servers << "\"" + obsAccess->getApiUrl() + "\": " +
+                   QString::fromUtf8(obsAccess->getTimingsJson().trimmed());
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::critical(this, tr("Error"), file.errorString(), QMessageBox::Ok);
+        return;
+    }
+    file.write("{\n" + servers.join(",\n").toUtf8() + "\n}\n");
+}
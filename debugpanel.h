@@ -0,0 +1,53 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DEBUGPANEL_H
+#define DEBUGPANEL_H
+
+#include <QDialog>
+#include <QFileDialog>
+#include <QMessageBox>
+#include "obsaccess.h"
+
+namespace Ui {
+class DebugPanel;
+}
+
+class DebugPanel : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DebugPanel(QWidget *parent = 0);
+    ~DebugPanel();
+
+public slots:
+    void refresh();
+
+private:
+    Ui::DebugPanel *ui;
+
+private slots:
+    void on_pushButton_Refresh_clicked();
+    void on_pushButton_Reset_clicked();
+    void on_pushButton_Save_clicked();
+};
+
+#endif // DEBUGPANEL_H
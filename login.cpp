@@ -53,3 +53,19 @@ QString Login::getPassword()
 {
     return ui->lineEdit_Password->text();
 }
+
+QString Login::getApiUrl()
+{
+    return ui->comboBox_Server->currentText().trimmed();
+}
+
+void Login::setApiUrl(const QString& apiUrl)
+{
+//    The servers we already know about can be picked from the list
+    int index = ui->comboBox_Server->findText(apiUrl);
+    if (index == -1) {
+        ui->comboBox_Server->addItem(apiUrl);
+        index = ui->comboBox_Server->count() - 1;
+    }
+    ui->comboBox_Server->setCurrentIndex(index);
+}
@@ -40,6 +40,8 @@ public:
     QString getUsername();
     void setUsername(const QString&);
     QString getPassword();
+    QString getApiUrl();
+    void setApiUrl(const QString&);
 
 private:
     Ui::Login *ui;
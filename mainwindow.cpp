@@ -26,6 +26,7 @@
 #include "configure.h"
 #include "login.h"
 #include "roweditor.h"
+#include "debugpanel.h"
 
 #include "obsaccess.h"
 #include "obspackage.h"
@@ -37,9 +38,7 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    obsAccess = OBSaccess::getInstance();
-    obsAccess->setApiUrl("https://api.opensuse.org");
-    obsPackage = new OBSpackage();
+    refreshing = false;
 
     createToolbar();
     trayIcon = new TrayIcon(this);
@@ -50,21 +49,99 @@ MainWindow::MainWindow(QWidget *parent) :
 
     loginDialog = new Login(this);
     configureDialog = new Configure(this);
+    debugPanel = new DebugPanel(this);
+//    Overall deadline for a refresh
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(300000);
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refreshTimedOut()));
     ui->actionConfigure_Qactus->setEnabled(false);
 
-    connect(obsAccess, SIGNAL(isAuthenticated(bool)), this, SLOT(enableButtons(bool)));
+    connect(configureDialog, SIGNAL(watchModeChanged(bool)), this, SLOT(updateWatches()));
+    connect(configureDialog, SIGNAL(watchModeChanged(bool)), this, SLOT(updateScheduler()));
+    connect(configureDialog, SIGNAL(timerChanged()), this, SLOT(updateScheduler()));
+    connect(configureDialog, SIGNAL(rateLimitsChanged()), this, SLOT(updateRateLimits()));
 
     readSettings();
 
-    // Show login dialog on startup if user isn't logged in
-    if(!obsAccess->isAuthenticated()) {
+    // Reuse the stored sessions if there are any, the login dialog
+    // is shown for a server without one or when it has expired (see enableButtons())
+    OBSaccess *loginInstance = NULL;
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        if (obsAccess->hasSession() && !obsAccess->getUsername().isEmpty()) {
+            statusBar()->showMessage(tr("Logging in..."), 0);
+            obsAccess->login();
+        } else if (!loginInstance && !obsAccess->isAuthenticated()) {
+            loginInstance = obsAccess;
+        }
+    }
+    if (loginInstance) {
+        // Show login dialog on startup if user isn't logged in
         // Centre login dialog
         loginDialog->move(this->geometry().center().x()-loginDialog->geometry().center().x(),
                           this->geometry().center().y()-loginDialog->geometry().center().y());
-        loginDialog->show();
+        showLoginDialog(loginInstance);
     }
 }
 
+void MainWindow::addInstance(OBSaccess *obsAccess)
+{
+//    Each OBS server has its own OBSaccess (and thread, connections,
+//    cache and credentials) and its own scheduler
+    if (pollSchedulers.contains(obsAccess)) {
+        return;
+    }
+    qDebug() << "Adding OBS instance" << obsAccess->getApiUrl();
+    PollScheduler *pollScheduler = new PollScheduler(this);
+    pollSchedulers.insert(obsAccess, pollScheduler);
+
+    connect(obsAccess, SIGNAL(isAuthenticated(bool)), this, SLOT(enableButtons(bool)));
+    connect(obsAccess, SIGNAL(requestFailed(int,QString)), this, SLOT(showRequestError(int,QString)));
+    connect(obsAccess, SIGNAL(finishedParsingPackage(OBSpackage,int)),
+            this, SLOT(insertBuildStatus(OBSpackage,int)));
+    connect(obsAccess, SIGNAL(finishedParsingResultList(QVector<OBSpackage>)),
+            this, SLOT(insertResultList(QVector<OBSpackage>)));
+    connect(obsAccess, SIGNAL(finishedParsingRequests(QVector<OBSrequest>,bool)),
+            this, SLOT(insertRequests(QVector<OBSrequest>,bool)));
+    connect(obsAccess, SIGNAL(requestFinished(int)), this, SLOT(finishedRequest(int)));
+    connect(pollScheduler, SIGNAL(pollDue(QStringList)), this, SLOT(pollRows(QStringList)));
+
+    obsAccess->setRateLimits(configureDialog->getRequestsPerSecond(),
+                             configureDialog->getBurstSize(),
+                             configureDialog->getMaxConnections());
+
+//    How long (seconds) cached listings are used before being revalidated
+    QSettings settings("Qactus","Qactus");
+    settings.beginGroup("Cache");
+    obsAccess->setListTtl(OBScacheManifest::ProjectList,
+                          settings.value("ProjectListTTL", obsAccess->getListTtl(OBScacheManifest::ProjectList)).toInt());
+    obsAccess->setListTtl(OBScacheManifest::PackageList,
+                          settings.value("PackageListTTL", obsAccess->getListTtl(OBScacheManifest::PackageList)).toInt());
+    obsAccess->setListTtl(OBScacheManifest::ProjectMeta,
+                          settings.value("MetaTTL", obsAccess->getListTtl(OBScacheManifest::ProjectMeta)).toInt());
+    settings.endGroup();
+    loginDialog->setApiUrl(obsAccess->getApiUrl());
+}
+
+OBSaccess *MainWindow::getObsAccess(QTreeWidgetItem *item)
+{
+//    Rows are tagged with the API URL of their server
+    return OBSaccess::getInstance(item->data(0, Qt::UserRole).toString());
+}
+
+void MainWindow::setRowApiUrl(QTreeWidgetItem *item, const QString &apiUrl)
+{
+    item->setData(0, Qt::UserRole, apiUrl);
+    item->setToolTip(0, apiUrl);
+}
+
+void MainWindow::showLoginDialog(OBSaccess *obsAccess)
+{
+    loginDialog->setApiUrl(obsAccess->getApiUrl());
+    loginDialog->setUsername(obsAccess->getUsername());
+    loginDialog->show();
+}
+
 MainWindow::~MainWindow()
 {
     writeSettings();
@@ -85,19 +162,72 @@ void MainWindow::changeEvent(QEvent *e)
 
 void MainWindow::enableButtons(bool isAuthenticated)
 {
-    action_Refresh->setEnabled(isAuthenticated);
-    action_Timer->setEnabled(isAuthenticated);
-    ui->actionConfigure_Qactus->setEnabled(isAuthenticated);
+//    The actions are available as long as we are logged in to a server.
+//    Each server signals its own login state, only its rows are updated.
+    OBSaccess *obsAccess = qobject_cast<OBSaccess*>(sender());
+    if (isAuthenticated) {
+        onlineInstances.insert(obsAccess);
+    } else {
+        onlineInstances.remove(obsAccess);
+    }
+    bool online = !onlineInstances.isEmpty();
+    action_Refresh->setEnabled(online);
+    action_Timer->setEnabled(online);
+    ui->actionConfigure_Qactus->setEnabled(online);
 
+//    Only login changes are signalled, not every successful reply.
+//    Row changes update the watches and the schedulers themselves.
     if (isAuthenticated) {
-        qDebug() << "User is authenticated";
-        readSettingsTimer();
+        qDebug() << "User is authenticated on" << obsAccess->getApiUrl();
+        updateWatches(obsAccess);
+        updateScheduler(obsAccess);
         statusBar()->showMessage(tr("Online"), 0);
     } else {
-        loginDialog->show();
+//        Nothing is polled while logged out
+        updateScheduler(obsAccess);
+//        Result lists which ended with 401 are incomplete too
+        foreach (int requestId, resultRequests.value(obsAccess).keys()) {
+            setResultRequestFailed(obsAccess, requestId);
+        }
+        showLoginDialog(obsAccess);
+    }
+}
+
+void MainWindow::showRequestError(int requestId, const QString &errorString)
+{
+//    Network and server errors don't log us out, they are shown
+//    in the status bar once the retries have been used up. Errors of
+//    the running refresh are also listed when it has finished.
+    statusBar()->showMessage(tr("Error: ") + errorString, 10000);
+    OBSaccess *obsAccess = qobject_cast<OBSaccess*>(sender());
+    if (refreshing && refreshRequests.value(obsAccess).contains(requestId)) {
+        packageErrors += errorString + "\n";
+    }
+    setResultRequestFailed(obsAccess, requestId);
+}
+
+void MainWindow::setResultRequestFailed(OBSaccess *obsAccess, int requestId)
+{
+//    No fallback to _status if the result list itself failed or was
+//    cancelled, only rows left out of a complete result list get one
+    if (resultRequests.value(obsAccess).contains(requestId)) {
+        resultRequests[obsAccess][requestId].failed = true;
     }
 }
 
+void MainWindow::cancelRefresh()
+{
+    QHashIterator<OBSaccess*, QList<int> > i(refreshRequests);
+    while (i.hasNext()) {
+        i.next();
+        foreach (int requestId, i.value()) {
+            setResultRequestFailed(i.key(), requestId);
+        }
+        i.key()->cancelRequests(i.value());
+    }
+    refreshRequests.clear();
+}
+
 void MainWindow::createToolbar()
 {
     action_Add = new QAction(tr("&Add"), this);
@@ -137,6 +267,8 @@ void MainWindow::addRow()
 
     if (rowEditor->exec()) {
         QTreeWidgetItem *item = new QTreeWidgetItem(ui->treePackages);
+        setRowApiUrl(item, rowEditor->getApiUrl());
+        addInstance(getObsAccess(item));
         item->setText(0, rowEditor->getProject());
         item->setText(1, rowEditor->getPackage());
         item->setText(2, rowEditor->getRepository());
@@ -144,6 +276,8 @@ void MainWindow::addRow()
         ui->treePackages->addTopLevelItem(item);
         int index = ui->treePackages->indexOfTopLevelItem(item);
         qDebug() << "Build" << item->text(1) << "added at" << index;
+        updateWatches();
+        updateScheduler();
     }
     delete rowEditor;
 }
@@ -152,6 +286,7 @@ void MainWindow::editRow(QTreeWidgetItem* item, int)
 {
     qDebug() << "Launching RowEditor in edit mode...";
     RowEditor *rowEditor = new RowEditor(this);
+    rowEditor->setApiUrl(getObsAccess(item)->getApiUrl());
     rowEditor->setProject(item->text(0));
     rowEditor->setPackage(item->text(1));
     rowEditor->setRepository(item->text(2));
@@ -160,6 +295,8 @@ void MainWindow::editRow(QTreeWidgetItem* item, int)
 
     if (rowEditor->exec()) {
         int index = ui->treePackages->indexOfTopLevelItem(item);
+        setRowApiUrl(item, rowEditor->getApiUrl());
+        addInstance(getObsAccess(item));
         item->setText(0, rowEditor->getProject());
         item->setText(1, rowEditor->getPackage());
         item->setText(2, rowEditor->getRepository());
@@ -168,6 +305,8 @@ void MainWindow::editRow(QTreeWidgetItem* item, int)
         ui->treePackages->insertTopLevelItem(index, item);
         qDebug() << "Build edited:" << index;
         qDebug() << "Status at" << index << item->text(4) << "(it should be empty)";
+        updateWatches();
+        updateScheduler();
     }
     delete rowEditor;
 }
@@ -185,6 +324,8 @@ void MainWindow::removeRow()
         if (index!=-1) {
             ui->treePackages->takeTopLevelItem(index);
             qDebug() << "Row removed:" << index;
+            updateWatches();
+            updateScheduler();
         } else {
             qDebug () << "No row selected";
         }
@@ -196,36 +337,310 @@ void MainWindow::removeRow()
 void MainWindow::refreshView()
 {
     qDebug() << "Refreshing view...";
+    if (refreshing) {
+//        The previous refresh is superseded by this one
+        cancelRefresh();
+    }
+    refreshRequests.clear();
+    packageErrors.clear();
+
+//    All the requests are sent at once, the rows are filled in
+//    by insertBuildStatus() as the replies come back. Each server
+//    has its own connections, so they are refreshed in parallel.
+    statusBar()->showMessage(tr("Getting build statuses..."), 0);
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        if (!obsAccess->isAuthenticated()) {
+            continue;
+        }
+        QList<int> requestIds = getBuildStatus(obsAccess, getRowsWithData(obsAccess));
+
+//        Get SRs
+        requestIds.append(obsAccess->getRequests());
+        refreshRequests.insert(obsAccess, requestIds);
+    }
+
+    refreshing = !refreshRequests.isEmpty();
+    if (refreshing) {
+        refreshTimer->start();
+    }
+}
+
+void MainWindow::refreshTimedOut()
+{
+    if (!refreshing) {
+        return;
+    }
+    qDebug() << "Refresh timed out";
+    cancelRefresh();
+    refreshing = false;
+    statusBar()->showMessage(tr("Refresh timed out"), 0);
+}
+
+QString MainWindow::getRowKey(QTreeWidgetItem *item)
+{
+    return item->text(0) + "/" + item->text(1) + "/" +
+            item->text(2) + "/" + item->text(3);
+}
+
+QString MainWindow::getPackageKey(const OBSpackage &obsPackage)
+{
+//    Same format as getRowKey()
+    return obsPackage.getProject() + "/" + obsPackage.getName() + "/" +
+            obsPackage.getRepository() + "/" + obsPackage.getArch();
+}
+
+QList<int> MainWindow::getRowsWithData(OBSaccess *obsAccess)
+{
+//    Ignore rows with empty cells, and rows of other servers
+//    if obsAccess is given
+    QList<int> rowsWithData;
     int rows = ui->treePackages->topLevelItemCount();
 
     for (int r=0; r<rows; r++) {
-//        Ignore rows with empty cells and process rows with data
-        if (ui->treePackages->topLevelItem(r)->text(0).isEmpty() ||
-                ui->treePackages->topLevelItem(r)->text(1).isEmpty() ||
-                ui->treePackages->topLevelItem(r)->text(2).isEmpty() ||
-                ui->treePackages->topLevelItem(r)->text(3).isEmpty()) {
+        QTreeWidgetItem *item = ui->treePackages->topLevelItem(r);
+        if (obsAccess && getObsAccess(item) != obsAccess) {
+            continue;
+        }
+        if (!item->text(0).isEmpty() && !item->text(1).isEmpty() &&
+                !item->text(2).isEmpty() && !item->text(3).isEmpty()) {
+            rowsWithData.append(r);
+        }
+    }
+    return rowsWithData;
+}
+
+QList<int> MainWindow::getBuildStatus(OBSaccess *obsAccess, const QList<int> &rows,
+                                       OBSaccess::Priority priority)
+{
+    if (configureDialog->isBatchedRefresh()) {
+        return getBuildStatusPerProject(obsAccess, rows, false, priority);
+    } else {
+        return getBuildStatusPerRow(obsAccess, rows, priority);
+    }
+}
+
+QList<int> MainWindow::getBuildStatusPerRow(OBSaccess *obsAccess, const QList<int> &rows,
+                                             OBSaccess::Priority priority)
+{
+    QList<int> requestIds;
+    foreach (int r, rows) {
+        QStringList tableStringList;
+        tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(0)));
+        tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(2)));
+        tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(3)));
+        tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(1)));
+//        Get build status
+        requestIds.append(obsAccess->getBuildStatus(tableStringList, r, priority));
+    }
+    return requestIds;
+}
+
+QList<int> MainWindow::getBuildStatusPerProject(OBSaccess *obsAccess, const QList<int> &rows,
+                                                 bool watch, OBSaccess::Priority priority)
+{
+//    Group the rows by project and get all their statuses with a single
+//    _result request per project. In watch mode the request is
+//    long-polled and re-armed by OBSaccess after each change
+    QMap<QString, QList<int> > rowsPerProject;
+    QList<int> requestIds;
+
+    foreach (int r, rows) {
+        rowsPerProject[ui->treePackages->topLevelItem(r)->text(0)].append(r);
+    }
+
+    QMapIterator<QString, QList<int> > i(rowsPerProject);
+    while (i.hasNext()) {
+        i.next();
+        QStringList packages;
+        QStringList repositories;
+        QStringList archs;
+        foreach (int r, i.value()) {
+            QTreeWidgetItem *item = ui->treePackages->topLevelItem(r);
+            if (!packages.contains(item->text(1))) {
+                packages.append(item->text(1));
+            }
+            if (!repositories.contains(item->text(2))) {
+                repositories.append(item->text(2));
+            }
+            if (!archs.contains(item->text(3))) {
+                archs.append(item->text(3));
+            }
+        }
+        qDebug() << "Getting results for" << i.key() << "(" << i.value().size() << "rows )";
+        if (watch) {
+            obsAccess->watchProject(i.key(), packages, repositories, archs);
         } else {
-            QStringList tableStringList;
-            tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(0)));
-            tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(2)));
-            tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(3)));
-            tableStringList.append(QString(ui->treePackages->topLevelItem(r)->text(1)));
-//            Get build status
-            statusBar()->showMessage(tr("Getting build statuses..."), 5000);
-            obsPackage = obsAccess->getBuildStatus(tableStringList);
-            insertBuildStatus(obsPackage, r);
+            int requestId = obsAccess->getProjectResults(i.key(), packages, repositories,
+                                                         archs, priority);
+//            Rows which the result list leaves out (eg: a misspelt package)
+//            get their status (or error) with _status once it has finished
+            ResultRequest resultRequest;
+            resultRequest.priority = priority;
+            resultRequest.failed = false;
+            foreach (int r, i.value()) {
+                QString key = getRowKey(ui->treePackages->topLevelItem(r));
+                resultRequest.keys.append(key);
+                resultKeys[obsAccess].remove(key);
+            }
+            resultRequests[obsAccess].insert(requestId, resultRequest);
+            requestIds.append(requestId);
+        }
+    }
+
+    if (watch) {
+//        Stop watching projects which no longer have rows
+        foreach (const QString &project, obsAccess->getWatchedProjects()) {
+            if (!rowsPerProject.contains(project)) {
+                obsAccess->stopWatching(project);
+            }
         }
     }
+    return requestIds;
+}
+
+void MainWindow::updateWatches()
+{
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        updateWatches(obsAccess);
+    }
+}
+
+void MainWindow::updateWatches(OBSaccess *obsAccess)
+{
+    if (obsAccess->isAuthenticated() && configureDialog->isWatchMode()) {
+        getBuildStatusPerProject(obsAccess, getRowsWithData(obsAccess), true);
+    } else {
+        obsAccess->stopWatching();
+    }
+}
+
+void MainWindow::updateScheduler()
+{
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        updateScheduler(obsAccess);
+    }
+}
+
+void MainWindow::updateScheduler(OBSaccess *obsAccess)
+{
+    PollScheduler *pollScheduler = pollSchedulers.value(obsAccess);
+
+//    Rows are long-polled in watch mode, so only the requests are scheduled
+    QStringList keys("requests");
+    if (!configureDialog->isWatchMode()) {
+        foreach (int r, getRowsWithData(obsAccess)) {
+            keys.append(getRowKey(ui->treePackages->topLevelItem(r)));
+        }
+    }
+
+    pollScheduler->setDefaultInterval(configureDialog->getTimerValue()*60000);
+    pollScheduler->setKeys(keys);
+    if (obsAccess->isAuthenticated() && configureDialog->isTimerActive()) {
+        pollScheduler->start();
+    } else {
+        pollScheduler->stop();
+    }
+}
+
+void MainWindow::pollRows(const QStringList &keys)
+{
+    OBSaccess *obsAccess = pollSchedulers.key(qobject_cast<PollScheduler*>(sender()));
+    if (!obsAccess) {
+        return;
+    }
+    QSet<QString> dueKeys = keys.toSet();
+    QList<int> rows;
+    foreach (int r, getRowsWithData(obsAccess)) {
+        if (dueKeys.contains(getRowKey(ui->treePackages->topLevelItem(r)))) {
+            rows.append(r);
+        }
+    }
+    qDebug() << "Polling" << rows.size() << "rows";
+//    Polls wait behind anything the user asked for
+    getBuildStatus(obsAccess, rows, OBSaccess::BackgroundPoll);
+
+    if (dueKeys.contains("requests")) {
+        obsAccess->getRequests(OBSaccess::BackgroundPoll);
+    }
+}
+
+void MainWindow::insertResultList(const QVector<OBSpackage> &resultList)
+{
+//    A result list can also contain combinations which aren't watched,
+//    so only the rows matching project/package/repository/arch are updated
+    QMultiHash<QString, int> rowsForKey;
+    OBSaccess *obsAccess = qobject_cast<OBSaccess*>(sender());
+    foreach (int r, getRowsWithData(obsAccess)) {
+        rowsForKey.insert(getRowKey(ui->treePackages->topLevelItem(r)), r);
+    }
+
+    foreach (const OBSpackage &package, resultList) {
+        QString key = getPackageKey(package);
+        foreach (int r, rowsForKey.values(key)) {
+            insertBuildStatus(package, r);
+        }
+        if (rowsForKey.contains(key)) {
+            resultKeys[obsAccess].insert(key);
+        }
+    }
+}
+
+void MainWindow::getMissingResults(OBSaccess *obsAccess, int requestId)
+{
+    if (!resultRequests.value(obsAccess).contains(requestId)) {
+        return;
+    }
+    ResultRequest resultRequest = resultRequests[obsAccess].take(requestId);
+    QSet<QString> missingKeys;
+    foreach (const QString &key, resultRequest.keys) {
+        if (!resultKeys[obsAccess].remove(key)) {
+            missingKeys.insert(key);
+        }
+    }
+    if (resultRequest.failed) {
+        return;
+    }
+
+    QList<int> rows;
+    foreach (int r, getRowsWithData(obsAccess)) {
+        if (missingKeys.contains(getRowKey(ui->treePackages->topLevelItem(r)))) {
+            rows.append(r);
+        }
+    }
+    if (rows.isEmpty()) {
+        return;
+    }
+    qDebug() << rows.size() << "rows missing from the result list, getting their _status";
+    QList<int> requestIds = getBuildStatusPerRow(obsAccess, rows, resultRequest.priority);
+    if (refreshing && refreshRequests.value(obsAccess).contains(requestId)) {
+        refreshRequests[obsAccess].append(requestIds);
+    }
+}
+
+void MainWindow::finishedRequest(int requestId)
+{
+//    The refresh is done once all of its requests (on all the servers)
+//    are done. Polls and other requests finishing meanwhile don't count.
+    OBSaccess *obsAccess = qobject_cast<OBSaccess*>(sender());
+    getMissingResults(obsAccess, requestId);
+    if (!refreshing || !refreshRequests.contains(obsAccess)) {
+        return;
+    }
+    refreshRequests[obsAccess].removeAll(requestId);
+    if (refreshRequests.value(obsAccess).isEmpty()) {
+        refreshRequests.remove(obsAccess);
+    }
+    if (!refreshRequests.isEmpty()) {
+        return;
+    }
+    refreshing = false;
+    refreshTimer->stop();
+    refreshRequests.clear();
 
     if (packageErrors.size()>1) {
         QMessageBox::critical(this,tr("Error"), packageErrors, QMessageBox::Ok );
         packageErrors.clear();
     }
-
-//    Get SRs
-    statusBar()->showMessage(tr("Getting requests..."), 5000);
-    obsRequests = obsAccess->getRequests();
-    insertRequests(obsRequests);
     statusBar()->showMessage(tr("Done"), 0);
 }
 
@@ -255,10 +670,19 @@ void MainWindow::createTreeRequests()
     connect(ui->treeRequests, SIGNAL(itemClicked(QTreeWidgetItem*, int)), this, SLOT(getDescription(QTreeWidgetItem*, int)));
 }
 
-void MainWindow::insertBuildStatus(OBSpackage* obsPackage, const int& row)
+void MainWindow::insertBuildStatus(const OBSpackage &obsPackage, int row)
 {
-    QString details = obsPackage->getDetails();
-    QString status = obsPackage->getStatus();
+//    The row might have been removed or edited while the request was running
+    QString key = getPackageKey(obsPackage);
+    if (row >= ui->treePackages->topLevelItemCount() ||
+            getRowKey(ui->treePackages->topLevelItem(row)) != key ||
+            getObsAccess(ui->treePackages->topLevelItem(row)) != sender()) {
+        qDebug() << "Row" << row << "no longer matches" << key;
+        return;
+    }
+
+    QString details = obsPackage.getDetails();
+    QString status = obsPackage.getStatus();
 
 //    If the line is too long (>250), break it
     details = breakLine(details, 250);
@@ -275,6 +699,10 @@ void MainWindow::insertBuildStatus(OBSpackage* obsPackage, const int& row)
 
     qDebug() << "Build status" << status << "inserted in" << row
              << "(Total rows:" << ui->treePackages->topLevelItemCount() << ")";
+    PollScheduler *pollScheduler = pollSchedulers.value(getObsAccess(item));
+    if (pollScheduler) {
+        pollScheduler->reportStatus(getRowKey(item), obsPackage.getStatusCode());
+    }
 
 //    If the old status is not empty and it is different from latest one,
 //    change the tray icon
@@ -343,55 +771,67 @@ void MainWindow::toggleItemFont(QTreeWidgetItem *item)
     }
 }
 
-void MainWindow::insertRequests(QList<OBSrequest*> obsRequests)
+void MainWindow::insertRequests(const QVector<OBSrequest> &obsRequests, bool append)
 {
-//    If we already have inserted submit requests,
-//    we remove them and insert the latest ones
+//    While a collection is being downloaded the requests arrive in
+//    batches, which are appended. The first batch replaces the
+//    submit requests we had already inserted from that server.
+    OBSaccess *obsAccess = qobject_cast<OBSaccess*>(sender());
+    QString apiUrl = obsAccess->getApiUrl();
     int rows = ui->treeRequests->topLevelItemCount();
     int requests = obsAccess->getRequestNumber();
     qDebug() << "InsertRequests() " << "Rows:" << rows << "Requests:" << requests;
 
-    if (rows>0) {
-        ui->treeRequests->clear();
+    if (!append) {
+        for (int r=rows-1; r>=0; r--) {
+            if (ui->treeRequests->topLevelItem(r)->data(0, Qt::UserRole).toString() == apiUrl) {
+                delete ui->treeRequests->takeTopLevelItem(r);
+                this->obsRequests.remove(r);
+            }
+        }
+        rows = ui->treeRequests->topLevelItemCount();
     }
+    this->obsRequests += obsRequests;
 
     qDebug() << "RequestNumber: " << obsAccess->getRequestNumber();
     qDebug() << "requests: " << requests;
-    qDebug() << "obsRequests size: " << obsRequests.size();
+    qDebug() << "obsRequests size: " << this->obsRequests.size();
 
     for (int i=0; i<obsRequests.size(); i++) {
         QTreeWidgetItem *item = new QTreeWidgetItem(ui->treeRequests);
-        item->setText(0, obsRequests.at(i)->getDate());
-        item->setText(1, obsRequests.at(i)->getId());
-        item->setText(2, obsRequests.at(i)->getSource());
-        item->setText(3, obsRequests.at(i)->getTarget());
-        item->setText(4, obsRequests.at(i)->getRequester());
-        item->setText(5, obsRequests.at(i)->getActionType());
-        item->setText(6, obsRequests.at(i)->getState());
-
-        ui->treeRequests->insertTopLevelItem(i, item);
+        item->setData(0, Qt::UserRole, apiUrl);
+        item->setToolTip(0, apiUrl);
+        item->setText(0, obsRequests.at(i).getDate());
+        item->setText(1, obsRequests.at(i).getId());
+        item->setText(2, obsRequests.at(i).getSource());
+        item->setText(3, obsRequests.at(i).getTarget());
+        item->setText(4, obsRequests.at(i).getRequester());
+        item->setText(5, obsRequests.at(i).getActionType());
+        item->setText(6, obsRequests.at(i).getState());
+
+        ui->treeRequests->insertTopLevelItem(rows + i, item);
     }
 }
 
 void MainWindow::getDescription(QTreeWidgetItem* item, int)
 {
     qDebug() << "getDescription() " << "Row: " + QString::number(ui->treeRequests->indexOfTopLevelItem(item));
-    qDebug() << "Description: " + obsRequests.at(ui->treeRequests->indexOfTopLevelItem(item))->getDescription();
-    ui->textBrowser->setText(obsRequests.at(ui->treeRequests->indexOfTopLevelItem(item))->getDescription());
+    qDebug() << "Description: " + obsRequests.at(ui->treeRequests->indexOfTopLevelItem(item)).getDescription();
+    ui->textBrowser->setText(obsRequests.at(ui->treeRequests->indexOfTopLevelItem(item)).getDescription());
 }
 
 void MainWindow::pushButton_Login_clicked()
 {
-    obsAccess->setCredentials(loginDialog->getUsername(), loginDialog->getPassword());
-
-//    Display a warning if the username/password is empty.
-    if (loginDialog->getUsername().isEmpty() || loginDialog->getPassword().isEmpty()) {
-        QMessageBox::warning(this,tr("Error"), tr("Empty username/password"), QMessageBox::Ok );
+//    Display a warning if the server/username/password is empty.
+    if (loginDialog->getApiUrl().isEmpty() || loginDialog->getUsername().isEmpty() ||
+            loginDialog->getPassword().isEmpty()) {
+        QMessageBox::warning(this,tr("Error"), tr("Empty server/username/password"), QMessageBox::Ok );
     } else {
+        OBSaccess *obsAccess = OBSaccess::getInstance(loginDialog->getApiUrl());
+        addInstance(obsAccess);
+        obsAccess->setCredentials(loginDialog->getUsername(), loginDialog->getPassword());
         loginDialog->close();
-        QProgressDialog progress(tr("Logging in..."), 0, 0, 0, this);
-        progress.setWindowModality(Qt::WindowModal);
-        progress.show();
+        statusBar()->showMessage(tr("Logging in..."), 0);
         obsAccess->login();
     }
 }
@@ -496,15 +936,33 @@ void MainWindow::writeSettings()
     settings.setValue("pos", pos());
     settings.endGroup();
 
-    settings.beginGroup("Auth");
-    settings.setValue("Username", obsAccess->getUsername());
-    settings.endGroup();
+    settings.remove("Auth");
+    settings.beginWriteArray("Instances");
+    settings.remove("");
+    int instance = 0;
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        settings.setArrayIndex(instance++);
+        settings.setValue("ApiUrl", obsAccess->getApiUrl());
+        settings.setValue("Username", obsAccess->getUsername());
+    }
+    settings.endArray();
 
     settings.beginGroup("Timer");
     settings.setValue("Active", configureDialog->isTimerActive());
     settings.setValue("Value", configureDialog->getTimerValue());
     settings.endGroup();
 
+    settings.beginGroup("RateLimit");
+    settings.setValue("RequestsPerSecond", configureDialog->getRequestsPerSecond());
+    settings.setValue("Burst", configureDialog->getBurstSize());
+    settings.setValue("Connections", configureDialog->getMaxConnections());
+    settings.endGroup();
+
+    settings.beginGroup("Refresh");
+    settings.setValue("Batched", configureDialog->isBatchedRefresh());
+    settings.setValue("Watch", configureDialog->isWatchMode());
+    settings.endGroup();
+
     int rows = ui->treePackages->topLevelItemCount();
     settings.beginWriteArray("Packages");
     settings.remove("");
@@ -517,6 +975,7 @@ void MainWindow::writeSettings()
                 !ui->treePackages->topLevelItem(i)->text(2).isEmpty() &&
                 !ui->treePackages->topLevelItem(i)->text(3).isEmpty())
         {
+            settings.setValue("ApiUrl", getObsAccess(ui->treePackages->topLevelItem(i))->getApiUrl());
             settings.setValue("Project",ui->treePackages->topLevelItem(i)->text(0));
             settings.setValue("Package",ui->treePackages->topLevelItem(i)->text(1));
             settings.setValue("Repository",ui->treePackages->topLevelItem(i)->text(2));
@@ -533,15 +992,45 @@ void MainWindow::readSettings()
     move(settings.value("pos", QPoint(200, 200)).toPoint());
     settings.endGroup();
 
-    settings.beginGroup("auth");
-    loginDialog->setUsername(settings.value("username").toString());
-    settings.endGroup();   
+    int instances = settings.beginReadArray("Instances");
+    for (int i=0; i<instances; ++i) {
+        settings.setArrayIndex(i);
+        OBSaccess *obsAccess = OBSaccess::getInstance(settings.value("ApiUrl").toString());
+        addInstance(obsAccess);
+        obsAccess->setCredentials(settings.value("Username").toString(), QString());
+    }
+    settings.endArray();
+
+//    Settings from before multiple servers were supported
+    if (instances == 0) {
+        settings.beginGroup("Auth");
+        OBSaccess *obsAccess = OBSaccess::getInstance();
+        addInstance(obsAccess);
+        obsAccess->setCredentials(settings.value("Username").toString(), QString());
+        settings.endGroup();
+    }
+
+    settings.beginGroup("Refresh");
+    configureDialog->setCheckedBatchedCheckbox(settings.value("Batched", true).toBool());
+    configureDialog->setCheckedWatchCheckbox(settings.value("Watch", false).toBool());
+    settings.endGroup();
+
+    settings.beginGroup("RateLimit");
+    configureDialog->setRateLimits(settings.value("RequestsPerSecond", 5.0).toDouble(),
+                                   settings.value("Burst", 10).toInt(),
+                                   settings.value("Connections", 6).toInt());
+    settings.endGroup();
+    updateRateLimits();
+
+    readSettingsTimer();
 
     int size = settings.beginReadArray("Packages");
     for (int i=0; i<size; ++i)
         {
             settings.setArrayIndex(i);
             QTreeWidgetItem *item = new QTreeWidgetItem(ui->treePackages);
+            setRowApiUrl(item, settings.value("ApiUrl", OBSaccess::getDefaultApiUrl()).toString());
+            addInstance(getObsAccess(item));
             item->setText(0, settings.value("Project").toString());
             item->setText(1, settings.value("Package").toString());
             item->setText(2, settings.value("Repository").toString());
@@ -555,27 +1044,53 @@ void MainWindow::readSettingsTimer()
 {
     QSettings settings("Qactus","Qactus");
     settings.beginGroup("Timer");
-    if (settings.value("Active").toBool()) {
-        qDebug () << "Timer Active = true";
-        configureDialog->setCheckedTimerCheckbox(true);
-        configureDialog->startTimer(settings.value("value").toInt()*60000);
-    } else {
-        qDebug () << "Timer Active = false";
-        configureDialog->setTimerValue(settings.value("value").toInt());
-    }
+    qDebug () << "Timer Active =" << settings.value("Active").toBool();
+    configureDialog->setCheckedTimerCheckbox(settings.value("Active").toBool());
+    configureDialog->setTimerValue(settings.value("Value").toInt());
     settings.endGroup();
 }
 
 void MainWindow::on_actionConfigure_Qactus_triggered()
 {
+    QStringList queueStats;
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        queueStats.append(QUrl(obsAccess->getApiUrl()).host() + ": " +
+                          tr("Queued: %1 (max. %2), wait (avg./max. ms): "
+                             "interactive %3/%4, refresh %5/%6, polls %7/%8")
+                          .arg(obsAccess->getQueueDepth())
+                          .arg(obsAccess->getMaxQueueDepth())
+                          .arg(obsAccess->getAverageQueueWait(OBSaccess::Interactive))
+                          .arg(obsAccess->getMaxQueueWait(OBSaccess::Interactive))
+                          .arg(obsAccess->getAverageQueueWait(OBSaccess::UserRefresh))
+                          .arg(obsAccess->getMaxQueueWait(OBSaccess::UserRefresh))
+                          .arg(obsAccess->getAverageQueueWait(OBSaccess::BackgroundPoll))
+                          .arg(obsAccess->getMaxQueueWait(OBSaccess::BackgroundPoll)));
+    }
+    configureDialog->setQueueStats(queueStats.join("\n"));
     configureDialog->show();
 }
 
+void MainWindow::updateRateLimits()
+{
+//    The limits apply to each server on its own
+    foreach (OBSaccess *obsAccess, pollSchedulers.keys()) {
+        obsAccess->setRateLimits(configureDialog->getRequestsPerSecond(),
+                                 configureDialog->getBurstSize(),
+                                 configureDialog->getMaxConnections());
+    }
+}
+
 void MainWindow::on_actionLogin_triggered()
 {
     loginDialog->show();
 }
 
+void MainWindow::on_actionNetwork_Statistics_triggered()
+{
+    debugPanel->refresh();
+    debugPanel->show();
+}
+
 void MainWindow::on_tabWidget_currentChanged(const int& index)
 {
     // Disable add and remove for the request tab
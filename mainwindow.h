@@ -40,9 +40,14 @@
 #include <QTableWidgetItem>
 #include <QAction>
 #include <QTimer>
+#include <QSet>
 #include <QSslError>
 #include <QCoreApplication>
 #include "trayicon.h"
+#include "obspackage.h"
+#include "obsrequest.h"
+#include "pollscheduler.h"
+#include "obsaccess.h"
 
 namespace Ui {
     class MainWindow;
@@ -52,10 +57,8 @@ class Login;
 class TrayIcon;
 class OBSxmlReader;
 class Configure;
+class DebugPanel;
 
-class OBSaccess;
-class OBSpackage;
-class OBSrequest;
 
 class MainWindow : public QMainWindow
 {
@@ -71,9 +74,11 @@ protected:
 private:
     Ui::MainWindow *ui;
 
-    OBSaccess *obsAccess;
-    OBSpackage *obsPackage;
-    QList<OBSrequest*> obsRequests;
+    QVector<OBSrequest> obsRequests;
+    void addInstance(OBSaccess *obsAccess);
+    OBSaccess *getObsAccess(QTreeWidgetItem *item);
+    void setRowApiUrl(QTreeWidgetItem *item, const QString &apiUrl);
+    void showLoginDialog(OBSaccess *obsAccess);
 
     QToolBar *toolBar;
     void createToolbar();
@@ -99,9 +104,33 @@ private:
     void readSettingsTimer();
 
     QString packageErrors;
+    bool refreshing;
+    QHash<OBSaccess*, QList<int> > refreshRequests;
+    struct ResultRequest {
+        QStringList keys;
+        OBSaccess::Priority priority;
+        bool failed;
+    };
+    QHash<OBSaccess*, QHash<int, ResultRequest> > resultRequests;
+    QHash<OBSaccess*, QSet<QString> > resultKeys;
+    void getMissingResults(OBSaccess *obsAccess, int requestId);
+    void updateWatches(OBSaccess *obsAccess);
+    void updateScheduler(OBSaccess *obsAccess);
+    void setResultRequestFailed(OBSaccess *obsAccess, int requestId);
+    void cancelRefresh();
+    QTimer *refreshTimer;
+    QHash<OBSaccess*, PollScheduler*> pollSchedulers;
+    QSet<OBSaccess*> onlineInstances;
+    QString getRowKey(QTreeWidgetItem *item);
+    QString getPackageKey(const OBSpackage &obsPackage);
+    QList<int> getRowsWithData(OBSaccess *obsAccess = 0);
+    QList<int> getBuildStatus(OBSaccess *obsAccess, const QList<int> &rows,
+                              OBSaccess::Priority priority = OBSaccess::UserRefresh);
+    QList<int> getBuildStatusPerRow(OBSaccess *obsAccess, const QList<int> &rows,
+                                    OBSaccess::Priority priority);
+    QList<int> getBuildStatusPerProject(OBSaccess *obsAccess, const QList<int> &rows, bool watch,
+                                        OBSaccess::Priority priority = OBSaccess::UserRefresh);
 
-    void insertBuildStatus(OBSpackage*, const int&);
-    void insertRequests(QList<OBSrequest*>);
     QString breakLine(QString&, const int&);
     QColor getColorForStatus(const QString&);
     void toggleItemFont(QTreeWidgetItem*);
@@ -110,14 +139,25 @@ private:
 
     Login *loginDialog;
     Configure *configureDialog;
+    DebugPanel *debugPanel;
 
 private slots:
     void enableButtons(bool);
+    void showRequestError(int, const QString&);
     void getDescription(QTreeWidgetItem*, int);
     void addRow();
     void editRow(QTreeWidgetItem*, int);
     void removeRow();
     void refreshView();
+    void finishedRequest(int requestId);
+    void refreshTimedOut();
+    void updateWatches();
+    void updateScheduler();
+    void updateRateLimits();
+    void pollRows(const QStringList &keys);
+    void insertBuildStatus(const OBSpackage&, int);
+    void insertResultList(const QVector<OBSpackage>&);
+    void insertRequests(const QVector<OBSrequest>&, bool);
     void lineEdit_Password_returnPressed();
     void pushButton_Login_clicked();
     void on_actionAbout_triggered(bool);
@@ -127,6 +167,7 @@ private slots:
     void about();
     void on_actionConfigure_Qactus_triggered();
     void on_actionLogin_triggered();
+    void on_actionNetwork_Statistics_triggered();
     void on_tabWidget_currentChanged(const int&);
 };
 
@@ -20,13 +20,81 @@
 
 #include "obsaccess.h"
 
-OBSaccess* OBSaccess::instance = NULL;
+QMap<QString, OBSaccess*> OBSaccess::instances;
 
-OBSaccess::OBSaccess()
+OBSaccess::OBSaccess(const QString &apiUrl)
 {
+    this->apiUrl = apiUrl;
     authenticated = false;
     manager = NULL;
-    xmlReader = OBSxmlReader::getInstance();
+    watchManager = NULL;
+    cache = new OBScache();
+    manifest = new OBScacheManifest();
+    manifest->load(getDataFileName("manifest"));
+    metaCache = new OBSmetaCache();
+    cookieJar = new OBScookieJar(QDir(OBSxmlReader::getDataDir()).filePath(getDataFileName("cookies")), this);
+    maxConcurrentRequests = 6;
+    requestsPerSecond = 5.0;
+    burstSize = 10;
+    queueDepth = 0;
+    maxQueueDepth = 0;
+    for (int p=0; p<PriorityCount; p++) {
+        startedRequests[p] = 0;
+        totalQueueWait[p] = 0;
+        maxQueueWait[p] = 0;
+    }
+    watchRetryInterval = 30000;
+    watchTimeout = 600000;
+    lastRequestId = 0;
+    coalescedRequests = 0;
+    requestNumber = 0;
+    maxRetries = 4;
+    maxRetryDelay = 300000;
+    retriedRequests = 0;
+    failedRequests = 0;
+    breakerThreshold = 5;
+    breakerInterval = 30000;
+    wakeUpTimer = new QTimer(this);
+    wakeUpTimer->setSingleShot(true);
+    connect(wakeUpTimer, SIGNAL(timeout()), this, SLOT(startPendingRequests()));
+    requestTimeout = 120000;
+    stallTimeout = 30000;
+    timedOutRequests = 0;
+    timeoutTimer = new QTimer(this);
+    timeoutTimer->setInterval(1000);
+    connect(timeoutTimer, SIGNAL(timeout()), this, SLOT(checkTimeouts()));
+    warmUpConnections = 2;
+
+    qRegisterMetaType<OBSpackage>("OBSpackage");
+    qRegisterMetaType<QVector<OBSpackage> >("QVector<OBSpackage>");
+    qRegisterMetaType<QVector<OBSrequest> >("QVector<OBSrequest>");
+
+//    Downloading and parsing happen on the worker thread, so that the
+//    GUI keeps responding while a refresh is running
+    workerThread = new QThread();
+    moveToThread(workerThread);
+    connect(workerThread, SIGNAL(started()), this, SLOT(initWorker()));
+    connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()),
+            this, SLOT(quitWorker()), Qt::DirectConnection);
+    workerThread->start();
+}
+
+void OBSaccess::initWorker()
+{
+//    qrand() is seeded per thread, it is used for the retry jitter
+    qsrand(QDateTime::currentDateTime().toTime_t() ^ quintptr(this));
+
+//    The managers (and their connections) live as long as the worker,
+//    they are not recreated when logging in again
+    createManager();
+    sslConfiguration = QSslConfiguration::defaultConfiguration();
+    sslConfiguration.setProtocol(QSsl::SecureProtocols);
+}
+
+void OBSaccess::quitWorker()
+{
+    workerThread->quit();
+    workerThread->wait();
 }
 
 void OBSaccess::createManager()
@@ -36,32 +104,76 @@ void OBSaccess::createManager()
     SLOT(provideAuthentication(QNetworkReply*,QAuthenticator*)));
     connect(manager, SIGNAL(finished(QNetworkReply*)), this, SLOT(replyFinished(QNetworkReply*)));
     connect(manager, SIGNAL(sslErrors(QNetworkReply*, const QList<QSslError> &)), this, SLOT(onSslErrors(QNetworkReply*, const QList<QSslError> &)));
+    manager->setCookieJar(cookieJar);
+
+//    Long-polls stay open for minutes, so they get their own manager
+//    (and connections) instead of taking slots from the regular requests
+    watchManager = new QNetworkAccessManager();
+    connect(watchManager, SIGNAL(authenticationRequired(QNetworkReply*,QAuthenticator*)),
+    SLOT(provideAuthentication(QNetworkReply*,QAuthenticator*)));
+    connect(watchManager, SIGNAL(finished(QNetworkReply*)), this, SLOT(watchReplyFinished(QNetworkReply*)));
+    connect(watchManager, SIGNAL(sslErrors(QNetworkReply*, const QList<QSslError> &)), this, SLOT(onSslErrors(QNetworkReply*, const QList<QSslError> &)));
+    watchManager->setCookieJar(cookieJar);
+//    Both managers share the jar, so neither of them owns it
+    cookieJar->setParent(this);
 }
 
-OBSaccess* OBSaccess::getInstance()
+OBSaccess* OBSaccess::getInstance(const QString &apiUrl)
 {
+//    There is one instance per OBS server, each of them with its own
+//    thread, managers, cache, cookies and credentials
+    QString url = apiUrl.isEmpty() ? getDefaultApiUrl() : apiUrl;
+    while (url.endsWith("/")) {
+        url.chop(1);
+    }
+    OBSaccess *instance = instances.value(url);
     if (!instance) {
-        instance = new OBSaccess();
+        instance = new OBSaccess(url);
+        instances.insert(url, instance);
     }
     return instance;
 }
 
-void OBSaccess::setCredentials(const QString& username, const QString& password)
+QList<OBSaccess*> OBSaccess::getInstances()
 {
-//    Allow login with another username/password
-    delete manager;
-    createManager();
+    return instances.values();
+}
+
+QString OBSaccess::getDefaultApiUrl()
+{
+    return "https://api.opensuse.org";
+}
 
+QString OBSaccess::getDataFileName(const QString &name)
+{
+//    Listings and cookies of each server are kept in their own directory
+    return QUrl(getApiUrl()).host() + "/" + name;
+}
+
+void OBSaccess::setCredentials(const QString& username, const QString& password)
+{
+//    Allow login with another username/password. The session
+//    cookie belongs to the previous user, so it is dropped.
+    QMutexLocker locker(&mutex);
+    if (!curUsername.isEmpty() && curUsername != username) {
+        cookieJar->clear();
+    }
     curUsername = username;
     curPassword = password;
 }
 
+bool OBSaccess::hasSession()
+{
+    return cookieJar->hasCookiesFor(QUrl(getApiUrl()));
+}
+
 QString OBSaccess::getUsername()
 {
+    QMutexLocker locker(&mutex);
     return curUsername;
 }
 
-void OBSaccess::request(const QString &urlStr)
+QNetworkRequest OBSaccess::createRequest(const QString &urlStr)
 {
     QNetworkRequest request;
     request.setUrl(QUrl(urlStr));
@@ -69,23 +181,657 @@ void OBSaccess::request(const QString &urlStr)
             QCoreApplication::applicationVersion();
     qDebug() << "User-Agent:" << userAgent;
     request.setRawHeader("User-Agent", userAgent.toAscii());
-    manager->get(request);
 
-//    Don't make a new request until we get a reply
-    QEventLoop *loop = new QEventLoop;
-    connect(manager, SIGNAL(finished(QNetworkReply *)),loop, SLOT(quit()));
-    loop->exec();
+//    Credentials are sent up front instead of waiting for a 401
+//    challenge. Without a password we rely on the session cookie.
+    QMutexLocker locker(&mutex);
+    if (!curPassword.isEmpty()) {
+        request.setRawHeader("Authorization", "Basic " +
+                             (curUsername + ":" + curPassword).toUtf8().toBase64());
+    }
+
+//    All the requests use the same TLS configuration, the one the
+//    warmed up connections were opened with
+    request.setSslConfiguration(sslConfiguration);
+    return request;
 }
 
-void OBSaccess::setApiUrl(const QString &apiUrl)
+int OBSaccess::request(const QString &urlStr, RequestType type, Priority priority,
+                       int row, const QString &fileName)
 {
-    this->apiUrl = apiUrl;
+//    The id is handed out right away, the request itself
+//    is queued on the worker thread
+    int id = lastRequestId.fetchAndAddOrdered(1) + 1;
+    mutex.lock();
+    activeRequestIds.insert(id);
+    mutex.unlock();
+    QMetaObject::invokeMethod(this, "enqueueRequest", Qt::QueuedConnection,
+                              Q_ARG(int, id), Q_ARG(QString, urlStr), Q_ARG(int, type),
+                              Q_ARG(int, priority), Q_ARG(int, row), Q_ARG(QString, fileName));
+    return id;
+}
+
+void OBSaccess::enqueueRequest(int id, const QString &urlStr, int type, int priority,
+                               int row, const QString &fileName)
+{
+//    Several rows (or RowEditor and a refresh) can ask for the same URL
+//    at once. Instead of opening another reply, the request is attached
+//    to the one which is already queued or running.
+    PendingRequest *existingRequest = findRequest(QUrl(urlStr), static_cast<RequestType>(type));
+    if (existingRequest) {
+        existingRequest->attachedIds.append(id);
+        existingRequest->attachedRows.append(row);
+//        Sorting moves the requests around, existingRequest isn't valid after it
+        int existingId = existingRequest->id;
+        if (priority < existingRequest->priority) {
+//            It is moved ahead if it is still queued
+            existingRequest->priority = static_cast<Priority>(priority);
+            qStableSort(pendingRequests.begin(), pendingRequests.end(), hasHigherPriority);
+        }
+        mutex.lock();
+        coalescedRequests++;
+        mutex.unlock();
+        qDebug() << "Request" << id << "attached to" << existingId << urlStr;
+        return;
+    }
+
+    PendingRequest pendingRequest;
+    pendingRequest.id = id;
+    pendingRequest.request = createRequest(urlStr);
+    cache->prepareRequest(pendingRequest.request);
+    if (!fileName.isEmpty()) {
+//        The cached listing is revalidated, even after a restart
+        manifest->prepareRequest(fileName, pendingRequest.request);
+    }
+//    As we ask for compression ourselves, QNAM leaves the body compressed
+//    and readReplyData() inflates it while it streams in
+    pendingRequest.request.setRawHeader("Accept-Encoding", "gzip, deflate");
+    pendingRequest.type = static_cast<RequestType>(type);
+    pendingRequest.row = row;
+    pendingRequest.fileName = fileName;
+    pendingRequest.xmlReader = NULL;
+    pendingRequest.inflater = NULL;
+    pendingRequest.wireBytes = 0;
+    pendingRequest.parsedBytes = 0;
+    pendingRequest.parseTime = 0;
+    pendingRequest.requestsEmitted = false;
+    pendingRequest.attempts = 0;
+    pendingRequest.queuedAt = QDateTime::currentDateTime();
+    pendingRequest.priority = static_cast<Priority>(priority);
+    queueRequest(pendingRequest, false);
+
+    startPendingRequests();
+}
+
+void OBSaccess::queueRequest(const PendingRequest &pendingRequest, bool first)
+{
+//    The queue is sorted by priority, so that interactive requests go
+//    ahead of queued refreshes, and refreshes ahead of background polls.
+//    Within a class requests keep their order (retries go first).
+    int index = 0;
+    while (index < pendingRequests.size() &&
+           (pendingRequests.at(index).priority < pendingRequest.priority ||
+            (!first && pendingRequests.at(index).priority == pendingRequest.priority))) {
+        index++;
+    }
+    pendingRequests.insert(index, pendingRequest);
+}
+
+bool OBSaccess::hasHigherPriority(const PendingRequest &a, const PendingRequest &b)
+{
+    return a.priority < b.priority;
+}
+
+OBSaccess::PendingRequest *OBSaccess::findRequest(const QUrl &url, RequestType type)
+{
+    QMutableListIterator<PendingRequest> i(pendingRequests);
+    while (i.hasNext()) {
+        PendingRequest &pendingRequest = i.next();
+        if (pendingRequest.type == type && pendingRequest.request.url() == url) {
+            return &pendingRequest;
+        }
+    }
+
+    QMutableHashIterator<QNetworkReply*, PendingRequest> j(runningRequests);
+    while (j.hasNext()) {
+        PendingRequest &pendingRequest = j.next().value();
+        if (pendingRequest.type == type && pendingRequest.request.url() == url) {
+            return &pendingRequest;
+        }
+    }
+    return NULL;
+}
+
+void OBSaccess::finishRequest(const PendingRequest &pendingRequest)
+{
+    finishRequest(pendingRequest.id);
+    foreach (int id, pendingRequest.attachedIds) {
+        finishRequest(id);
+    }
+}
+
+void OBSaccess::finishRequest(int requestId)
+{
+    mutex.lock();
+    activeRequestIds.remove(requestId);
+    mutex.unlock();
+    emit requestFinished(requestId);
+}
+
+void OBSaccess::cancelRequest(int requestId)
+{
+    QMetaObject::invokeMethod(this, "abortRequest", Qt::QueuedConnection, Q_ARG(int, requestId));
+}
+
+void OBSaccess::cancelRequests(const QList<int> &requestIds)
+{
+    foreach (int requestId, requestIds) {
+        cancelRequest(requestId);
+    }
+}
+
+void OBSaccess::cancelListRequests()
+{
+    QList<int> requestIds;
+    foreach (const PendingRequest &pendingRequest, pendingRequests + runningRequests.values()) {
+        if (pendingRequest.type == List) {
+            requestIds << pendingRequest.id << pendingRequest.attachedIds;
+        }
+    }
+    foreach (int requestId, requestIds) {
+        abortRequest(requestId);
+    }
+}
+
+void OBSaccess::abortRequest(int requestId)
+{
+//    Callers attached to the same request keep it alive,
+//    it is only dropped when nobody is waiting for it anymore
+    QMutableListIterator<PendingRequest> i(pendingRequests);
+    while (i.hasNext()) {
+        PendingRequest &pendingRequest = i.next();
+        if (pendingRequest.id == requestId || pendingRequest.attachedIds.contains(requestId)) {
+            if (!detachRequest(pendingRequest, requestId)) {
+                i.remove();
+            }
+            qDebug() << "Request" << requestId << "cancelled (queued)";
+            finishRequest(requestId);
+            checkAllRequestsFinished();
+            return;
+        }
+    }
+
+    QMutableHashIterator<QNetworkReply*, PendingRequest> j(runningRequests);
+    while (j.hasNext()) {
+        PendingRequest &pendingRequest = j.next().value();
+        if (pendingRequest.id == requestId || pendingRequest.attachedIds.contains(requestId)) {
+            if (!detachRequest(pendingRequest, requestId)) {
+                QNetworkReply *reply = j.key();
+                pendingRequest.xmlReader->discardStream();
+                delete pendingRequest.xmlReader;
+                delete pendingRequest.inflater;
+                releaseHost(reply->url().host());
+                j.remove();
+//                replyFinished() ignores it, as it is no longer running
+                reply->abort();
+            }
+            qDebug() << "Request" << requestId << "cancelled (running)";
+            finishRequest(requestId);
+            startPendingRequests();
+            checkAllRequestsFinished();
+            return;
+        }
+    }
+}
+
+bool OBSaccess::detachRequest(PendingRequest &pendingRequest, int requestId)
+{
+//    Returns false if there are no other callers left
+    int index = pendingRequest.attachedIds.indexOf(requestId);
+    if (index != -1) {
+        pendingRequest.attachedIds.removeAt(index);
+        pendingRequest.attachedRows.removeAt(index);
+        return true;
+    }
+    if (pendingRequest.attachedIds.isEmpty()) {
+        return false;
+    }
+    pendingRequest.id = pendingRequest.attachedIds.takeFirst();
+    pendingRequest.row = pendingRequest.attachedRows.takeFirst();
+    return true;
+}
+
+void OBSaccess::checkAllRequestsFinished()
+{
+    if (pendingRequests.isEmpty() && runningRequests.isEmpty()) {
+        emit allRequestsFinished();
+    }
+}
+
+void OBSaccess::checkTimeouts()
+{
+//    A reply times out when it takes longer than requestTimeout overall,
+//    or when no data has arrived for stallTimeout
+    QDateTime now = QDateTime::currentDateTime();
+    QList<QNetworkReply*> expiredReplies;
+    QHashIterator<QNetworkReply*, PendingRequest> i(runningRequests);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().deadline < now || i.value().stallDeadline < now) {
+            expiredReplies.append(i.key());
+        }
+    }
+
+//    A long-poll which has been silent for watchTimeout is re-armed,
+//    in case the connection died without us noticing
+    QHashIterator<QNetworkReply*, QString> j(watchReplies);
+    while (j.hasNext()) {
+        j.next();
+        if (watches.value(j.value()).deadline < now) {
+            qDebug() << "Watch for" << j.value() << "timed out";
+            j.key()->setProperty("timedOut", true);
+            j.key()->abort();
+        }
+    }
+
+    foreach (QNetworkReply *reply, expiredReplies) {
+        qDebug() << "Request timed out:" << reply->url();
+        reply->setProperty("timedOut", true);
+        mutex.lock();
+        timedOutRequests++;
+        mutex.unlock();
+//        replyFinished() handles it like a network timeout
+        reply->abort();
+    }
+
+    if (runningRequests.isEmpty() && watchReplies.isEmpty()) {
+        timeoutTimer->stop();
+    }
+}
+
+void OBSaccess::startPendingRequests()
+{
+//    Requests waiting to be retried, for a host whose circuit is open,
+//    or for the rate limit of their host stay in the queue. The wake-up
+//    timer goes off when the first of them can be sent.
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime wakeUp;
+    int maxConcurrentRequests = getMaxConcurrentRequests();
+
+    QHash<QString, int> runningPerHost;
+    foreach (QNetworkReply *reply, runningRequests.keys()) {
+        runningPerHost[reply->url().host()]++;
+    }
+
+    QMutableListIterator<PendingRequest> i(pendingRequests);
+    while (i.hasNext()) {
+        PendingRequest pendingRequest = i.next();
+        QString host = pendingRequest.request.url().host();
+        if (pendingRequest.notBefore.isValid() && pendingRequest.notBefore > now) {
+            if (!wakeUp.isValid() || pendingRequest.notBefore < wakeUp) {
+                wakeUp = pendingRequest.notBefore;
+            }
+            continue;
+        }
+        if (runningPerHost.value(host) >= maxConcurrentRequests) {
+//            replyFinished() starts the queue again
+            continue;
+        }
+        if (!hasToken(host, now, wakeUp) || !acquireHost(host, now, wakeUp)) {
+            continue;
+        }
+        buckets[host].tokens -= 1.0;
+        runningPerHost[host]++;
+        i.remove();
+
+        mutex.lock();
+        int queueWait = pendingRequest.queuedAt.msecsTo(now);
+        startedRequests[pendingRequest.priority]++;
+        totalQueueWait[pendingRequest.priority] += queueWait;
+        maxQueueWait[pendingRequest.priority] = qMax(maxQueueWait[pendingRequest.priority], queueWait);
+        mutex.unlock();
+
+//        Each reply gets its own reader, so that it can be parsed while
+//        it is being downloaded, independently of the other replies
+        pendingRequest.xmlReader = new OBSxmlReader();
+        pendingRequest.xmlReader->setFileName(pendingRequest.fileName);
+        pendingRequest.deadline = now.addMSecs(requestTimeout);
+        pendingRequest.stallDeadline = now.addMSecs(stallTimeout);
+        QNetworkReply *reply = manager->get(pendingRequest.request);
+        connect(reply, SIGNAL(readyRead()), this, SLOT(replyReadyRead()));
+        watchConnection(reply);
+        runningRequests.insert(reply, pendingRequest);
+    }
+
+    if (wakeUp.isValid()) {
+        wakeUpTimer->start(qMax(qint64(0), now.msecsTo(wakeUp)));
+    }
+    if (!runningRequests.isEmpty() && !timeoutTimer->isActive()) {
+        timeoutTimer->start();
+    }
+
+    mutex.lock();
+    queueDepth = pendingRequests.size();
+    maxQueueDepth = qMax(maxQueueDepth, queueDepth);
+    mutex.unlock();
+    qDebug() << "Requests running:" << runningRequests.size()
+             << "queued:" << pendingRequests.size();
+}
+
+bool OBSaccess::hasToken(const QString &host, const QDateTime &now, QDateTime &wakeUp)
+{
+//    Token bucket: requestsPerSecond tokens are added per second, up to
+//    burstSize. Each request takes one.
+    mutex.lock();
+    double rate = requestsPerSecond;
+    int burst = burstSize;
+    mutex.unlock();
+
+    if (!buckets.contains(host)) {
+        TokenBucket bucket;
+        bucket.tokens = burst;
+        bucket.lastRefill = now;
+        buckets.insert(host, bucket);
+    }
+
+    TokenBucket &bucket = buckets[host];
+    bucket.tokens = qMin(double(burst),
+                         bucket.tokens + bucket.lastRefill.msecsTo(now)*rate/1000.0);
+    bucket.lastRefill = now;
+    if (bucket.tokens >= 1.0) {
+        return true;
+    }
+
+    QDateTime nextToken = now.addMSecs(qint64((1.0 - bucket.tokens)*1000.0/rate) + 1);
+    if (!wakeUp.isValid() || nextToken < wakeUp) {
+        wakeUp = nextToken;
+    }
+    return false;
+}
+
+bool OBSaccess::acquireHost(const QString &host, const QDateTime &now, QDateTime &wakeUp)
+{
+    if (!hosts.contains(host) || hosts.value(host).failures < breakerThreshold) {
+//        Closed circuit
+        return true;
+    }
+
+    HostState &state = hosts[host];
+    if (state.probing) {
+//        Wait for the probe, replyFinished() starts the queue again
+        return false;
+    }
+    if (state.openUntil > now) {
+        if (!wakeUp.isValid() || state.openUntil < wakeUp) {
+            wakeUp = state.openUntil;
+        }
+        return false;
+    }
+
+//    Half-open: a single request is let through to probe the host
+    qDebug() << "Probing" << host;
+    state.probing = true;
+    return true;
+}
+
+void OBSaccess::releaseHost(const QString &host)
+{
+//    A cancelled probe, let another request through
+    if (hosts.contains(host)) {
+        hosts[host].probing = false;
+    }
+}
+
+void OBSaccess::recordHostSuccess(const QString &host)
+{
+    if (hosts.contains(host)) {
+        if (hosts.value(host).failures >= breakerThreshold) {
+            qDebug() << "Circuit for" << host << "closed";
+        }
+        hosts.remove(host);
+    }
+}
+
+void OBSaccess::recordHostFailure(const QString &host)
+{
+    if (!hosts.contains(host)) {
+        HostState state;
+        state.failures = 0;
+        state.openInterval = breakerInterval;
+        state.probing = false;
+        hosts.insert(host, state);
+    }
+
+    HostState &state = hosts[host];
+    state.failures++;
+    if (state.failures >= breakerThreshold) {
+//        Open the circuit (again after a failed probe), for longer each time
+        state.openUntil = QDateTime::currentDateTime().addMSecs(state.openInterval);
+        qDebug() << "Circuit for" << host << "open until" << state.openUntil.toString();
+        state.openInterval = qMin(state.openInterval*2, maxRetryDelay);
+        state.probing = false;
+    }
+}
+
+bool OBSaccess::isRetryable(QNetworkReply *reply)
+{
+//    All our requests are idempotent GETs, so they can be sent again
+//    after server errors, rate limiting and connection problems
+    int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (httpStatusCode==429 || httpStatusCode>=500 || reply->property("timedOut").toBool()) {
+        return true;
+    }
+
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int OBSaccess::getRetryDelay(QNetworkReply *reply, int attempts)
+{
+//    Retry-After is either a number of seconds or an HTTP date
+    if (reply->hasRawHeader("Retry-After")) {
+        QString retryAfter = QString::fromAscii(reply->rawHeader("Retry-After")).trimmed();
+        bool ok;
+        int seconds = retryAfter.toInt(&ok);
+        if (ok) {
+            return qBound(0, seconds*1000, maxRetryDelay);
+        }
+        QDateTime date = QLocale::c().toDateTime(retryAfter.left(25), "ddd, dd MMM yyyy hh:mm:ss");
+        if (date.isValid()) {
+            date.setTimeSpec(Qt::UTC);
+            return int(qBound(qint64(0), QDateTime::currentDateTime().msecsTo(date),
+                              qint64(maxRetryDelay)));
+        }
+    }
+
+//    Exponential backoff (1, 2, 4, 8 s...) with jitter
+    int backoff = qMin(1000 << qMin(attempts, 8), maxRetryDelay);
+    return backoff/2 + qrand() % (backoff/2 + 1);
+}
+
+void OBSaccess::retryRequest(QNetworkReply *reply, const PendingRequest &pendingRequest)
+{
+    PendingRequest retry = pendingRequest;
+    int delay = getRetryDelay(reply, retry.attempts);
+    retry.attempts++;
+    retry.notBefore = QDateTime::currentDateTime().addMSecs(delay);
+    retry.queuedAt = retry.notBefore;
+    retry.xmlReader = NULL;
+    retry.inflater = NULL;
+    retry.wireBytes = 0;
+    retry.parsedBytes = 0;
+    retry.parseTime = 0;
+    retry.body.clear();
+//    The partial results are sent again from the start
+    retry.requestsEmitted = false;
+    queueRequest(retry, true);
+
+    mutex.lock();
+    retriedRequests++;
+    mutex.unlock();
+    qDebug() << "Retrying" << reply->url() << "in" << delay << "ms (attempt"
+             << retry.attempts << "of" << maxRetries << ")";
+}
+
+bool OBSaccess::isRequestPending(int requestId)
+{
+    QMutexLocker locker(&mutex);
+    return activeRequestIds.contains(requestId);
+}
+
+bool OBSaccess::waitForRequest(int requestId, int timeout)
+{
+//    Used by callers which need the result right away (eg: RowEditor).
+//    The caller's event loop keeps running while we wait, as
+//    requestFinished() is delivered to it as a queued signal.
+//    The request is cancelled if it isn't finished within timeout ms.
+    QEventLoop loop;
+    QTimer timer;
+    timer.setSingleShot(true);
+    connect(this, SIGNAL(requestFinished(int)), &loop, SLOT(quit()));
+    connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+    timer.start(timeout);
+
+    while (isRequestPending(requestId)) {
+        if (!timer.isActive()) {
+            qDebug() << "Gave up waiting for request" << requestId;
+            mutex.lock();
+            timedOutRequests++;
+            mutex.unlock();
+            cancelRequest(requestId);
+            return false;
+        }
+        loop.exec();
+    }
+    return true;
+}
+
+void OBSaccess::setMaxConcurrentRequests(int maxConcurrentRequests)
+{
+    QMutexLocker locker(&mutex);
+    this->maxConcurrentRequests = qMax(1, maxConcurrentRequests);
+}
+
+void OBSaccess::setRateLimits(double requestsPerSecond, int burstSize, int maxConcurrentRequests)
+{
+    mutex.lock();
+    this->requestsPerSecond = qMax(0.1, requestsPerSecond);
+    this->burstSize = qMax(1, burstSize);
+    this->maxConcurrentRequests = qMax(1, maxConcurrentRequests);
+    mutex.unlock();
+    qDebug() << "Rate limits:" << requestsPerSecond << "requests/s, burst:" << burstSize
+             << "connections per host:" << maxConcurrentRequests;
+//    More requests may be allowed now
+    QMetaObject::invokeMethod(this, "startPendingRequests", Qt::QueuedConnection);
+}
+
+double OBSaccess::getRequestsPerSecond()
+{
+    QMutexLocker locker(&mutex);
+    return requestsPerSecond;
+}
+
+int OBSaccess::getBurstSize()
+{
+    QMutexLocker locker(&mutex);
+    return burstSize;
+}
+
+int OBSaccess::getQueueDepth()
+{
+    QMutexLocker locker(&mutex);
+    return queueDepth;
+}
+
+int OBSaccess::getMaxQueueDepth()
+{
+    QMutexLocker locker(&mutex);
+    return maxQueueDepth;
+}
+
+int OBSaccess::getAverageQueueWait(Priority priority)
+{
+    QMutexLocker locker(&mutex);
+    return startedRequests[priority] ?
+                int(totalQueueWait[priority]/startedRequests[priority]) : 0;
+}
+
+int OBSaccess::getMaxQueueWait(Priority priority)
+{
+    QMutexLocker locker(&mutex);
+    return maxQueueWait[priority];
+}
+
+int OBSaccess::getMaxConcurrentRequests()
+{
+    QMutexLocker locker(&mutex);
+    return maxConcurrentRequests;
+}
+
+int OBSaccess::getCacheHits()
+{
+    return cache->getHits();
+}
+
+int OBSaccess::getCacheMisses()
+{
+    return cache->getMisses();
+}
+
+qint64 OBSaccess::getCacheSavedBytes()
+{
+    return cache->getSavedBytes();
+}
+
+int OBSaccess::getCoalescedRequests()
+{
+    QMutexLocker locker(&mutex);
+    return coalescedRequests;
+}
+
+int OBSaccess::getRetriedRequests()
+{
+    QMutexLocker locker(&mutex);
+    return retriedRequests;
+}
+
+int OBSaccess::getFailedRequests()
+{
+    QMutexLocker locker(&mutex);
+    return failedRequests;
+}
+
+int OBSaccess::getTimedOutRequests()
+{
+    QMutexLocker locker(&mutex);
+    return timedOutRequests;
+}
+
+void OBSaccess::countFailure()
+{
+    QMutexLocker locker(&mutex);
+    failedRequests++;
+}
+
+QString OBSaccess::getApiUrl()
+{
+    QMutexLocker locker(&mutex);
+    return apiUrl;
 }
 
 void OBSaccess::provideAuthentication(QNetworkReply *reply, QAuthenticator *ator)
 {
-    static QString prevPassword = "";
-    static QString prevUsername = "";
 //    qDebug() << reply->readAll();
 
     if (reply->error()!=QNetworkReply::NoError)
@@ -95,30 +841,61 @@ void OBSaccess::provideAuthentication(QNetworkReply *reply, QAuthenticator *ator
     }
     else
     {
-        if ((curPassword != prevPassword) || (curUsername != prevUsername)) {
-            prevPassword = curPassword;
-            prevUsername = curUsername;
+//        Several replies can be challenged at the same time, so keep track
+//        of the attempts per reply instead of globally
+        QMutexLocker locker(&mutex);
+        if (!reply->property("authenticationAttempted").toBool() && !curPassword.isEmpty()) {
+            reply->setProperty("authenticationAttempted", true);
             ator->setUser(curUsername);
             ator->setPassword(curPassword);
 //            statusBar()->showMessage(tr("Authenticating..."), 5000);
         } else {
             qDebug() << "Authentication failed";
-            prevPassword = "";
-            prevUsername = "";
-
         }
     }
 
     if (reply->error()==QNetworkReply::NoError) {
+        QMutexLocker locker(&mutex);
         authenticated = true;
     }
 }
 
+void OBSaccess::setLoginFailed(const PendingRequest &pendingRequest)
+{
+//    A failed login is signalled even if we weren't logged in,
+//    so that the user is asked for the credentials again
+    if (pendingRequest.type == Login && !isAuthenticated()) {
+        emit isAuthenticated(false);
+    } else {
+        setAuthenticated(false);
+    }
+}
+
 bool OBSaccess::isAuthenticated()
 {
+    QMutexLocker locker(&mutex);
     return authenticated;
 }
 
+void OBSaccess::setAuthenticated(bool authenticated)
+{
+//    Every successful reply confirms the login, only changes are signalled
+    mutex.lock();
+    if (authenticated == this->authenticated) {
+        mutex.unlock();
+        return;
+    }
+    bool loggedIn = authenticated;
+    this->authenticated = authenticated;
+    mutex.unlock();
+    emit isAuthenticated(authenticated);
+
+    if (loggedIn) {
+//        Watches aren't re-armed while logged out
+        QMetaObject::invokeMethod(this, "startWatches", Qt::QueuedConnection);
+    }
+}
+
 void OBSaccess::replyFinished(QNetworkReply *reply)
 {
       // QNetworkReply is a sequential-access QIODevice, which means that
@@ -126,75 +903,615 @@ void OBSaccess::replyFinished(QNetworkReply *reply)
       // It is therefore the application's responsibility to keep this data if it needs to.
       // See http://doc.qt.nokia.com/latest/qnetworkreply.html for more info
 
-    data = (QString) reply->readAll();
+    if (!runningRequests.contains(reply)) {
+//        Aborted or left over from a previous manager
+        reply->deleteLater();
+        return;
+    }
+
+    PendingRequest pendingRequest = runningRequests.take(reply);
     qDebug() << "URL:" << reply->url();
     int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     qDebug() << "HTTP status code:" << httpStatusCode;
-//    qDebug() << "Network Reply: " << data;
-
-    if (httpStatusCode==404 && isAuthenticated()) {
-        xmlReader->addData(data);
-    } else if (reply->error() != QNetworkReply::NoError) {
-        authenticated = false;
-        emit isAuthenticated(authenticated);
-        qDebug() << "Request failed!";
-
-//        packageErrors += reply->errorString() + "\n\n";
-//        qDebug() << "Request failed, " << packageErrors;
-////        QMessageBox::critical(this,tr("Error"), tr("An error has occured:\n") + reply->errorString(), QMessageBox::Ok );
-////        statusBar()->showMessage(tr("Error ") + reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toString(), 500000);
-//        return;
+
+    readReplyData(reply, pendingRequest);
+//    A corrupt or truncated compressed body is handled like a broken
+//    connection: nothing of it is kept and the request is sent again
+    if (pendingRequest.inflater &&
+            (reply->error() == QNetworkReply::NoError || httpStatusCode==404)) {
+        pendingRequest.inflater->endStream();
+    }
+    bool inflateFailed = pendingRequest.inflater && pendingRequest.inflater->hasError();
+    QString errorString = inflateFailed ? tr("Corrupt compressed reply") : reply->errorString();
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    if (inflateFailed) {
+        qDebug() << "Inflating the reply failed!";
+    } else if (!pendingRequest.fileName.isEmpty()) {
+//        Listings are streamed to disk and revalidated by the manifest,
+//        on a 304 the file on disk is the body
+    } else if (cache->isNotModified(reply)) {
+//        304 Not Modified, the cached body is parsed instead
+        pendingRequest.xmlReader->addStreamData(cache->getData(reply));
+    } else if (httpStatusCode==200) {
+        cache->insert(reply, pendingRequest.body);
+    }
+    if (!inflateFailed && (reply->error() == QNetworkReply::NoError || httpStatusCode==404)) {
+        pendingRequest.xmlReader->endStream();
     } else {
-        authenticated = true;
-        emit isAuthenticated(authenticated);
+        pendingRequest.xmlReader->discardStream();
+    }
+    pendingRequest.parseTime += parseTimer.elapsed();
+    recordTimings(reply, pendingRequest);
+
+    if (pendingRequest.type == List && reply->error() == QNetworkReply::NoError && !inflateFailed) {
+//        If the new file couldn't be written the previous one was kept,
+//        and so are its validators
+        if (httpStatusCode==200 && !pendingRequest.xmlReader->hasFileError()) {
+            manifest->update(pendingRequest.fileName, reply, pendingRequest.parsedBytes);
+            if (pendingRequest.fileName.endsWith("_meta.xml")) {
+                metaCache->invalidate(pendingRequest.fileName);
+            }
+        } else if (httpStatusCode==304) {
+//            The file on disk is still valid
+            manifest->touch(pendingRequest.fileName);
+        }
+    }
+
+    QString host = reply->url().host();
+    bool retried = false;
+    if (!inflateFailed && httpStatusCode==404 && isAuthenticated()) {
+        recordHostSuccess(host);
+        emitResult(pendingRequest);
+    } else if (!inflateFailed && reply->error() == QNetworkReply::NoError) {
+        recordHostSuccess(host);
+        setAuthenticated(true);
         qDebug() << "Request succeeded!";
-        xmlReader->addData(data);
+        emitResult(pendingRequest);
+    } else if (httpStatusCode==401) {
+//        Only wrong credentials log us out
+        qDebug() << "Authentication failed!";
+        recordHostSuccess(host);
+        countFailure();
+        setLoginFailed(pendingRequest);
+    } else {
+        qDebug() << "Request failed!" << errorString;
+        if (inflateFailed || isRetryable(reply)) {
+            recordHostFailure(host);
+            if (pendingRequest.attempts < maxRetries) {
+                retryRequest(reply, pendingRequest);
+                retried = true;
+            }
+        } else {
+//            The host answered, the request itself is wrong
+            recordHostSuccess(host);
+        }
+
+        if (!retried) {
+            countFailure();
+            emit requestFailed(pendingRequest.id, errorString);
+            foreach (int id, pendingRequest.attachedIds) {
+                emit requestFailed(id, errorString);
+            }
+            if (pendingRequest.type == Login) {
+                setLoginFailed(pendingRequest);
+            }
+        }
+    }
+
+    qDebug() << "Received" << pendingRequest.wireBytes << "bytes, parsed"
+             << pendingRequest.parsedBytes << "bytes";
+    delete pendingRequest.xmlReader;
+    delete pendingRequest.inflater;
+    reply->deleteLater();
+    if (!retried) {
+        finishRequest(pendingRequest);
+    }
+
+    startPendingRequests();
+    checkAllRequestsFinished();
+}
+
+void OBSaccess::replyReadyRead()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (runningRequests.contains(reply)) {
+        runningRequests[reply].stallDeadline = QDateTime::currentDateTime().addMSecs(stallTimeout);
+        readReplyData(reply, runningRequests[reply]);
+    }
+}
+
+void OBSaccess::readReplyData(QNetworkReply *reply, PendingRequest &pendingRequest)
+{
+//    Only the bodies of successful replies and of 404 status
+//    documents are parsed
+    int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (httpStatusCode!=200 && httpStatusCode!=404) {
+        return;
+    }
+
+    QByteArray chunk = reply->readAll();
+    if (chunk.isEmpty()) {
+        return;
+    }
+    pendingRequest.wireBytes += chunk.size();
+
+    if (!pendingRequest.inflater &&
+            OBSinflater::isSupported(reply->rawHeader("Content-Encoding"))) {
+        pendingRequest.inflater = new OBSinflater();
+    }
+    if (pendingRequest.inflater) {
+        chunk = pendingRequest.inflater->inflate(chunk);
+//        After an error the rest of the body is dropped, replyFinished() retries
+        if (pendingRequest.inflater->hasError() || chunk.isEmpty()) {
+            return;
+        }
+    }
+    pendingRequest.parsedBytes += chunk.size();
+
+//    The whole body is only kept when it can be cached, listings
+//    are already written to a file by the reader
+    if (pendingRequest.fileName.isEmpty() && cache->isCacheable(reply)) {
+        pendingRequest.body.append(chunk);
+    }
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    pendingRequest.xmlReader->addStreamData(chunk);
+    emitPartialResult(pendingRequest);
+    pendingRequest.parseTime += parseTimer.elapsed();
+}
+
+void OBSaccess::recordTimings(QNetworkReply *reply, const PendingRequest &pendingRequest)
+{
+//    Qt4 doesn't tell when a connection is set up, so connecting (and
+//    the handshake) is part of waiting for the first byte.
+//    Parsing happens while downloading, so it is taken out of it.
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 startedAt = reply->property("startedAt").toLongLong();
+    qint64 firstByteAt = reply->property("firstByteAt").toLongLong();
+
+    qint64 phases[OBStimings::PhaseCount];
+    phases[OBStimings::Queued] = qMax(qint64(0), startedAt - pendingRequest.queuedAt.toMSecsSinceEpoch());
+    phases[OBStimings::Waiting] = (firstByteAt ? firstByteAt : now) - startedAt;
+    phases[OBStimings::Downloading] = firstByteAt ?
+                qMax(qint64(0), now - firstByteAt - pendingRequest.parseTime) : -1;
+    phases[OBStimings::Parsing] = pendingRequest.parseTime;
+
+    QString endpoint = OBStimings::getEndpoint(reply->url());
+    timings.record(endpoint, phases, pendingRequest.wireBytes, pendingRequest.parsedBytes);
+    qDebug() << "Timings for" << endpoint << "(ms): queued" << phases[OBStimings::Queued]
+             << "waiting" << phases[OBStimings::Waiting]
+             << "downloading" << phases[OBStimings::Downloading]
+             << "parsing" << phases[OBStimings::Parsing];
+}
+
+QString OBSaccess::getStatisticsReport()
+{
+//    The counters shown in the debug panel along with the timings
+    QStringList lines;
+    lines << QString("Cache: %1 hits, %2 misses, %3 bytes saved")
+             .arg(getCacheHits()).arg(getCacheMisses()).arg(getCacheSavedBytes());
+    lines << QString("Requests: %1 coalesced, %2 retried, %3 failed, %4 timed out")
+             .arg(getCoalescedRequests()).arg(getRetriedRequests())
+             .arg(getFailedRequests()).arg(getTimedOutRequests());
+    lines << QString("Queue: %1 queued, %2 at most").arg(getQueueDepth()).arg(getMaxQueueDepth());
+
+    const char* const priorityNames[] = { "interactive", "refresh", "poll" };
+    for (int p=0; p<PriorityCount; p++) {
+        Priority priority = static_cast<Priority>(p);
+        lines << QString("  %1 wait: avg. %2 ms, max. %3 ms")
+                 .arg(priorityNames[p], -12)
+                 .arg(getAverageQueueWait(priority))
+                 .arg(getMaxQueueWait(priority));
+    }
+    return lines.join("\n");
+}
+
+QString OBSaccess::getTimingsReport()
+{
+    return timings.toText();
+}
+
+QByteArray OBSaccess::getTimingsJson()
+{
+    return timings.toJson();
+}
+
+void OBSaccess::clearTimings()
+{
+    timings.clear();
+}
+
+void OBSaccess::emitPartialResult(PendingRequest &pendingRequest)
+{
+    OBSxmlReader *reader = pendingRequest.xmlReader;
+
+    switch (pendingRequest.type) {
+    case ResultList: {
+        QVector<OBSpackage> newResults = reader->takeNewResults();
+        if (!newResults.isEmpty()) {
+            emit finishedParsingResultList(newResults);
+        }
+        break;
+    }
+    case SubmitRequests: {
+//        The first batch replaces the requests of the previous collection,
+//        the following ones are appended to it
+        QVector<OBSrequest> newRequests = reader->takeNewRequests();
+        if (!newRequests.isEmpty()) {
+            emit finishedParsingRequests(newRequests, pendingRequest.requestsEmitted);
+            pendingRequest.requestsEmitted = true;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void OBSaccess::emitResult(PendingRequest &pendingRequest)
+{
+    OBSxmlReader *reader = pendingRequest.xmlReader;
+
+    switch (pendingRequest.type) {
+    case BuildStatus:
+        if (reader->hasPackage()) {
+//            Error documents (eg: 404 unknown_package) don't name the package,
+//            so the package is keyed by the request's URL:
+//            /build/<project>/<repository>/<arch>/<package>/_status
+            OBSpackage obsPackage = reader->getPackage();
+            QStringList path = pendingRequest.request.url().path().split("/", QString::SkipEmptyParts);
+            if (path.size() == 6) {
+                obsPackage.setProject(path.at(1));
+                obsPackage.setRepository(path.at(2));
+                obsPackage.setArch(path.at(3));
+                obsPackage.setName(path.at(4));
+            }
+            emit finishedParsingPackage(obsPackage, pendingRequest.row);
+            foreach (int row, pendingRequest.attachedRows) {
+                emit finishedParsingPackage(obsPackage, row);
+            }
+        }
+        break;
+    case ResultList:
+        emitPartialResult(pendingRequest);
+        break;
+    case SubmitRequests:
+        mutex.lock();
+        requestNumber = reader->getRequestNumber();
+        mutex.unlock();
+        emitPartialResult(pendingRequest);
+        if (!pendingRequest.requestsEmitted) {
+//            No requests at all, clear the previous ones
+            emit finishedParsingRequests(QVector<OBSrequest>(), false);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int OBSaccess::login()
+{
+//    The connections are opened while logging in, so that
+//    the first refresh doesn't have to wait for the handshakes
+    QMetaObject::invokeMethod(this, "warmUp", Qt::QueuedConnection);
+    return request(getApiUrl() + "/", Login, Interactive);
+}
+
+void OBSaccess::warmUp()
+{
+//    QNAM keeps the connections of finished replies open (up to six per
+//    host), so a few small requests sent at the same time as the login
+//    open them and do their TLS handshakes. The replies are dropped by
+//    replyFinished() as they aren't running requests.
+    QUrl url(getApiUrl());
+    qDebug() << "Opening" << warmUpConnections << "connections to" << url.host();
+    for (int i=0; i<warmUpConnections; i++) {
+        QNetworkReply *reply = manager->get(createRequest(getApiUrl() + "/about"));
+        reply->setProperty("warmUp", true);
+        watchConnection(reply);
     }
 }
 
-void OBSaccess::login()
+void OBSaccess::watchConnection(QNetworkReply *reply)
 {
-    request(apiUrl + "/");
+    reply->setProperty("startedAt", QDateTime::currentMSecsSinceEpoch());
+    connect(reply, SIGNAL(metaDataChanged()), this, SLOT(replyMetaDataChanged()));
 }
 
-OBSpackage* OBSaccess::getBuildStatus(const QStringList &stringList)
+void OBSaccess::replyMetaDataChanged()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (reply->property("firstByteLogged").toBool()) {
+        return;
+    }
+    reply->setProperty("firstByteLogged", true);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    reply->setProperty("firstByteAt", now);
+    qint64 elapsed = now - reply->property("startedAt").toLongLong();
+    if (reply->property("warmUp").toBool()) {
+//        Connecting, the handshake and the server's answer
+        qDebug() << "Connection to" << reply->url().host() << "ready in" << elapsed << "ms";
+    } else {
+        qDebug() << "Time to first byte for" << reply->url() << elapsed << "ms";
+    }
+}
+
+int OBSaccess::getBuildStatus(const QStringList &stringList, int row, Priority priority)
 {
 //    URL format: https://api.opensuse.org/build/KDE:Extra/openSUSE_13.2/x86_64/qrae/_status
-    request(apiUrl + "/build/"
+    return request(getApiUrl() + "/build/"
                  + stringList[0] + "/"
             + stringList[1] + "/"
             + stringList[2] + "/"
-            + stringList[3] + "/_status");
-    return xmlReader->getPackage();
+            + stringList[3] + "/_status", BuildStatus, priority, row);
+}
+
+int OBSaccess::getProjectResults(const QString &project, const QStringList &packages,
+                                 const QStringList &repositories, const QStringList &archs,
+                                 Priority priority)
+{
+//    URL format: https://api.opensuse.org/build/KDE:Extra/_result?package=qrae&repository=openSUSE_13.2&arch=x86_64
+    return request(getApiUrl() + "/build/" + project + "/_result" +
+                   createResultFilters(packages, repositories, archs), ResultList, priority);
 }
 
-QList<OBSrequest*> OBSaccess::getRequests()
+QString OBSaccess::createResultFilters(const QStringList &packages,
+                                       const QStringList &repositories, const QStringList &archs)
 {
-    request(apiUrl + "/request?view=collection&states=new&roles=maintainer&user=" + getUsername());
-    return xmlReader->getRequests();
+    QString filters;
+    foreach (const QString &package, packages) {
+        filters += "&package=" + QUrl::toPercentEncoding(package);
+    }
+    foreach (const QString &repository, repositories) {
+        filters += "&repository=" + QUrl::toPercentEncoding(repository);
+    }
+    foreach (const QString &arch, archs) {
+        filters += "&arch=" + QUrl::toPercentEncoding(arch);
+    }
+    filters.replace(0, 1, "?");
+    return filters;
+}
+
+void OBSaccess::watchProject(const QString &project, const QStringList &packages,
+                             const QStringList &repositories, const QStringList &archs)
+{
+    mutex.lock();
+    if (!watchedProjects.contains(project)) {
+        watchedProjects.append(project);
+    }
+    mutex.unlock();
+    QMetaObject::invokeMethod(this, "addWatch", Qt::QueuedConnection, Q_ARG(QString, project),
+                              Q_ARG(QString, createResultFilters(packages, repositories, archs)));
+}
+
+void OBSaccess::addWatch(const QString &project, const QString &filters)
+{
+    if (watches.contains(project) && watches.value(project).filters == filters) {
+//        Already watching the same rows
+        return;
+    }
+
+    removeWatch(project);
+    Watch watch;
+    watch.filters = filters;
+    watch.parsing = false;
+    watches.insert(project, watch);
+    startWatch(project);
+}
+
+void OBSaccess::stopWatching(const QString &project)
+{
+    mutex.lock();
+    watchedProjects.removeAll(project);
+    mutex.unlock();
+    QMetaObject::invokeMethod(this, "removeWatch", Qt::QueuedConnection, Q_ARG(QString, project));
+}
+
+void OBSaccess::removeWatch(const QString &project)
+{
+    watches.remove(project);
+    QNetworkReply *reply = watchReplies.key(project);
+    if (reply) {
+        watchReplies.remove(reply);
+        reply->abort();
+    }
+}
+
+void OBSaccess::stopWatching()
+{
+    foreach (const QString &project, getWatchedProjects()) {
+        stopWatching(project);
+    }
+}
+
+QStringList OBSaccess::getWatchedProjects()
+{
+    QMutexLocker locker(&mutex);
+    return watchedProjects;
+}
+
+void OBSaccess::startWatch(const QString &project)
+{
+    if (!watches.contains(project) || watches.value(project).parsing ||
+            watchReplies.key(project) || !isAuthenticated()) {
+        return;
+    }
+
+//    Without oldstate the current result is returned right away,
+//    with it the server holds the request until the state changes
+    Watch watch = watches.value(project);
+    QString urlStr = getApiUrl() + "/build/" + project + "/_result" + watch.filters;
+    if (!watch.state.isEmpty()) {
+        urlStr += "&oldstate=" + watch.state;
+    }
+    qDebug() << "Watching" << project << "state:" << watch.state;
+    watches[project].deadline = QDateTime::currentDateTime().addMSecs(watchTimeout);
+    watchReplies.insert(watchManager->get(createRequest(urlStr)), project);
+    if (!timeoutTimer->isActive()) {
+        timeoutTimer->start();
+    }
+}
+
+void OBSaccess::startWatches()
+{
+    foreach (const QString &project, watches.keys()) {
+        startWatch(project);
+    }
+}
+
+void OBSaccess::watchReplyFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    if (!watchReplies.contains(reply)) {
+//        Aborted by stopWatching()
+        return;
+    }
+
+    QString project = watchReplies.take(reply);
+    int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    qDebug() << "Watch for" << project << "finished. HTTP status code:" << httpStatusCode;
+
+    if (reply->error() == QNetworkReply::NoError) {
+        recordHostSuccess(reply->url().host());
+//        The result list is parsed on the thread pool,
+//        the watch is re-armed once it has been parsed
+        watches[project].parsing = true;
+        QFutureWatcher<OBSxmlReader*> *watcher = new QFutureWatcher<OBSxmlReader*>(this);
+        watcher->setProperty("project", project);
+        connect(watcher, SIGNAL(finished()), this, SLOT(watchReplyParsed()));
+        watcher->setFuture(QtConcurrent::run(OBSxmlReader::parseData, reply->readAll()));
+    } else if (reply->property("timedOut").toBool()) {
+        startWatch(project);
+    } else if (httpStatusCode==401) {
+//        Like replyFinished(), wrong credentials log us out. The watches
+//        are re-armed once we are logged in again.
+        qDebug() << "Watch for" << project << "failed: authentication failed!";
+        recordHostSuccess(reply->url().host());
+        countFailure();
+        setAuthenticated(false);
+    } else {
+//        Don't hammer the server, try again later
+        qDebug() << "Watch failed!" << reply->errorString();
+        countFailure();
+        if (isRetryable(reply)) {
+            recordHostFailure(reply->url().host());
+        }
+        QTimer::singleShot(watchRetryInterval, this, SLOT(startWatches()));
+    }
+}
+
+void OBSaccess::watchReplyParsed()
+{
+    QFutureWatcher<OBSxmlReader*> *watcher = static_cast<QFutureWatcher<OBSxmlReader*>*>(sender());
+    QString project = watcher->property("project").toString();
+    OBSxmlReader *reader = watcher->result();
+
+    if (watches.contains(project)) {
+        watches[project].state = reader->getResultListState();
+        watches[project].parsing = false;
+        emit finishedParsingResultList(reader->getResultList());
+        startWatch(project);
+    }
+
+    delete reader;
+    watcher->deleteLater();
+}
+
+int OBSaccess::getRequests(Priority priority)
+{
+    return request(getApiUrl() + "/request?view=collection&states=new&roles=maintainer&user=" + getUsername(),
+                   SubmitRequests, priority);
 }
 
 int OBSaccess::getRequestNumber()
 {
-    return xmlReader->getRequestNumber();
+    QMutexLocker locker(&mutex);
+    return requestNumber;
+}
+
+QStringList OBSaccess::getList(const QString &urlStr, const QString &fileName)
+{
+//    The listing is written to fileName while it is downloaded.
+//    Big listings (eg: /source) take a while to read, so that is
+//    done on the thread pool as well. If the download is cancelled
+//    or times out, the previous listing is read (if any).
+    waitForRequest(requestList(urlStr, fileName, Interactive));
+    QFutureWatcher<QStringList> watcher;
+    QEventLoop loop;
+    connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+    watcher.setFuture(QtConcurrent::run(OBSxmlReader::readList, fileName));
+    if (!watcher.isFinished()) {
+        loop.exec();
+    }
+    return watcher.result();
+}
+
+int OBSaccess::requestList(const QString &urlStr, const QString &fileName, Priority priority)
+{
+    return request(urlStr, List, priority, -1, fileName);
 }
 
 QStringList OBSaccess::getProjectList()
 {
-    request(apiUrl + "/source");
-    return xmlReader->getList();
+    return getList(getApiUrl() + "/source", getDataFileName("projects.xml"));
 }
 
 QStringList OBSaccess::getPackageListForProject(const QString &projectName)
 {
-    request(apiUrl + "/source/" + projectName);
-    return xmlReader->getList();
+    return getList(getApiUrl() + "/source/" + projectName, getDataFileName(projectName + ".xml"));
 }
 
 QStringList OBSaccess::getMetadataForProject(const QString &projectName)
 {
-    request(apiUrl + "/source/" + projectName + "/_meta");
-    return xmlReader->getList();
+    return getList(getApiUrl() + "/source/" + projectName + "/_meta",
+                   getDataFileName(projectName + "_meta.xml"));
+}
+
+OBSprojectMeta OBSaccess::getProjectMeta(const QString &projectName)
+{
+//    From the cached _meta, which is not downloaded here
+    return metaCache->get(getDataFileName(projectName + "_meta.xml"));
+}
+
+/*
+ * Stale listings are refreshed in the background while the cached file
+ * is still used (stale-while-revalidate). The request is conditional, so
+ * an unchanged listing costs a 304 Not Modified. requestFinished() is
+ * emitted once the file has been replaced (or confirmed).
+ *
+ */
+int OBSaccess::revalidateProjectList()
+{
+    return requestList(getApiUrl() + "/source", getDataFileName("projects.xml"), UserRefresh);
+}
+
+int OBSaccess::revalidatePackageList(const QString &projectName)
+{
+    return requestList(getApiUrl() + "/source/" + projectName,
+                       getDataFileName(projectName + ".xml"), UserRefresh);
+}
+
+int OBSaccess::revalidateMetadata(const QString &projectName)
+{
+    return requestList(getApiUrl() + "/source/" + projectName + "/_meta",
+                       getDataFileName(projectName + "_meta.xml"), UserRefresh);
+}
+
+bool OBSaccess::isListStale(const QString &fileName)
+{
+    return manifest->isStale(fileName);
+}
+
+void OBSaccess::setListTtl(OBScacheManifest::ResourceType type, int seconds)
+{
+    manifest->setTtl(type, seconds);
+}
+
+int OBSaccess::getListTtl(OBScacheManifest::ResourceType type)
+{
+    return manifest->getTtl(type);
 }
 
 void OBSaccess::onSslErrors(QNetworkReply* /*reply*/, const QList<QSslError> &list)
@@ -27,61 +27,311 @@
 #include <QAuthenticator>
 #include <QNetworkReply>
 #include <QSslError>
+#include <QSslConfiguration>
 #include <QDebug>
 #include <QEventLoop>
 #include <QCoreApplication>
+#include <QQueue>
+#include <QHash>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <QThread>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSet>
+#include <QDateTime>
+#include <QLocale>
+#include <QMap>
+#include <QElapsedTimer>
+#include <QtAlgorithms>
 #include "obsxmlreader.h"
 #include "obspackage.h"
+#include "obscache.h"
+#include "obscachemanifest.h"
+#include "obsmetacache.h"
+#include "obscookiejar.h"
+#include "obsinflater.h"
+#include "obstimings.h"
 
 class OBSxmlReader;
-class OBSpackage;
 
 class OBSaccess : public QObject
 {
      Q_OBJECT
 
 public:
-    static OBSaccess* getInstance();
+    enum Priority { Interactive, UserRefresh, BackgroundPoll, PriorityCount };
+    static OBSaccess* getInstance(const QString &apiUrl = QString());
+    static QList<OBSaccess*> getInstances();
+    static QString getDefaultApiUrl();
     bool isAuthenticated();
-    void setApiUrl(const QString &apiUrl);
-    void login();
-    OBSpackage* getBuildStatus(const QStringList &list);
+    QString getApiUrl();
+    QString getDataFileName(const QString &name);
+    void setMaxConcurrentRequests(int maxConcurrentRequests);
+    int getMaxConcurrentRequests();
+    void setRateLimits(double requestsPerSecond, int burstSize, int maxConcurrentRequests);
+    double getRequestsPerSecond();
+    int getBurstSize();
+    int getQueueDepth();
+    int getMaxQueueDepth();
+    int getAverageQueueWait(Priority priority);
+    int getMaxQueueWait(Priority priority);
+    int getCacheHits();
+    int getCacheMisses();
+    qint64 getCacheSavedBytes();
+    int getCoalescedRequests();
+    int getRetriedRequests();
+    int getFailedRequests();
+    int login();
+    int getBuildStatus(const QStringList &list, int row, Priority priority = UserRefresh);
+    int getProjectResults(const QString &project, const QStringList &packages,
+                          const QStringList &repositories, const QStringList &archs,
+                          Priority priority = UserRefresh);
     QString getUsername();
-    QList<OBSrequest*> getRequests();
+    bool hasSession();
+    int getRequests(Priority priority = UserRefresh);
     int getRequestNumber();
     QStringList getProjectList();
     QStringList getPackageListForProject(const QString &projectName);
     QStringList getMetadataForProject(const QString &projectName);
+    OBSprojectMeta getProjectMeta(const QString &projectName);
+    int revalidateProjectList();
+    int revalidatePackageList(const QString &projectName);
+    int revalidateMetadata(const QString &projectName);
+    bool isListStale(const QString &fileName);
+    void setListTtl(OBScacheManifest::ResourceType type, int seconds);
+    int getListTtl(OBScacheManifest::ResourceType type);
+    void watchProject(const QString &project, const QStringList &packages,
+                      const QStringList &repositories, const QStringList &archs);
+    void stopWatching(const QString &project);
+    void stopWatching();
+    QStringList getWatchedProjects();
+    bool isRequestPending(int requestId);
+    bool waitForRequest(int requestId, int timeout = 300000);
+    void cancelRequest(int requestId);
+    void cancelRequests(const QList<int> &requestIds);
+    int getTimedOutRequests();
+    QString getStatisticsReport();
+    QString getTimingsReport();
+    QByteArray getTimingsJson();
+    void clearTimings();
 
 signals:
     void isAuthenticated(bool authenticated);
+    void finishedParsingPackage(const OBSpackage &obsPackage, int row);
+    void finishedParsingResultList(const QVector<OBSpackage> &resultList);
+    void finishedParsingRequests(const QVector<OBSrequest> &obsRequests, bool append);
+    void requestFinished(int requestId);
+    void requestFailed(int requestId, const QString &errorString);
+    void allRequestsFinished();
 
 public slots:
     void setCredentials(const QString&, const QString&);
     void provideAuthentication(QNetworkReply* reply, QAuthenticator* ator);
     void replyFinished(QNetworkReply* reply);
     void onSslErrors(QNetworkReply* reply, const QList<QSslError> &list);
+    void cancelListRequests();
+
+private slots:
+    void enqueueRequest(int id, const QString &urlStr, int type, int priority,
+                        int row, const QString &fileName);
+    void addWatch(const QString &project, const QString &filters);
+    void removeWatch(const QString &project);
+    void initWorker();
+    void quitWorker();
+    void startPendingRequests();
+    void abortRequest(int requestId);
+    void checkTimeouts();
+    void replyReadyRead();
+    void warmUp();
+    void replyMetaDataChanged();
+    void watchReplyFinished(QNetworkReply* reply);
+    void watchReplyParsed();
+    void startWatches();
 
 private:
 /*
- * We need to instantiate QNAM only once, as it should be used as
- * as singleton or a utility instead of recreating it for each
- * request. This class (OBSaccess) uses the singleton pattern to
- * achieve this.
+ * We need to instantiate QNAM only once per server, as it should be
+ * used as a utility instead of recreating it for each request.
+ * OBSaccess keeps a single instance per API URL (see getInstance())
+ * to achieve this, so that each server has its own connections.
  *
  */
     QNetworkAccessManager* manager;
     void createManager();
-    OBSaccess();
-    static OBSaccess* instance;
+    OBSaccess(const QString &apiUrl);
+    static QMap<QString, OBSaccess*> instances;
     QString apiUrl;
-    void request(const QString &urlStr);
+
+/*
+ * OBSaccess lives in its own thread, where the replies are downloaded
+ * and parsed. The public methods can be called from the GUI thread:
+ * they hand the work over with queued invocations and results come
+ * back through queued signals. The few members which are read from
+ * both threads are guarded by mutex.
+ *
+ */
+    QThread *workerThread;
+    mutable QMutex mutex;
+    QSet<int> activeRequestIds;
+    QStringList watchedProjects;
+    void setAuthenticated(bool authenticated);
+
+/*
+ * Requests are queued and run asynchronously. At most
+ * maxConcurrentRequests replies per host are in flight at the same
+ * time, and a token bucket per host limits them to requestsPerSecond
+ * (with bursts of burstSize). The rest wait in pendingRequests, which
+ * is sorted by priority: interactive lookups, user refreshes and then
+ * background polls.
+ * A request for a URL which is already queued or running is attached
+ * to it instead of being sent again.
+ * Results are delivered through signals.
+ *
+ */
+    enum RequestType { Login, BuildStatus, ResultList, SubmitRequests, List };
+    struct PendingRequest {
+        int id;
+        QNetworkRequest request;
+        RequestType type;
+        int row;
+        QString fileName;
+        OBSxmlReader *xmlReader;
+        OBSinflater *inflater;
+        qint64 wireBytes;
+        qint64 parsedBytes;
+        qint64 parseTime;
+        QByteArray body;
+        bool requestsEmitted;
+        QList<int> attachedIds;
+        QList<int> attachedRows;
+        int attempts;
+        QDateTime notBefore;
+        QDateTime deadline;
+        QDateTime stallDeadline;
+        QDateTime queuedAt;
+        Priority priority;
+    };
+    void setLoginFailed(const PendingRequest &pendingRequest);
+    QNetworkRequest createRequest(const QString &urlStr);
+    int request(const QString &urlStr, RequestType type, Priority priority,
+                int row = -1, const QString &fileName = QString());
+    void queueRequest(const PendingRequest &pendingRequest, bool first);
+    static bool hasHigherPriority(const PendingRequest &a, const PendingRequest &b);
+    PendingRequest *findRequest(const QUrl &url, RequestType type);
+    void finishRequest(const PendingRequest &pendingRequest);
+    void finishRequest(int requestId);
+    bool detachRequest(PendingRequest &pendingRequest, int requestId);
+    void checkAllRequestsFinished();
+    void readReplyData(QNetworkReply *reply, PendingRequest &pendingRequest);
+    void emitPartialResult(PendingRequest &pendingRequest);
+    void emitResult(PendingRequest &pendingRequest);
+    QStringList getList(const QString &urlStr, const QString &fileName);
+    int requestList(const QString &urlStr, const QString &fileName, Priority priority);
+    QQueue<PendingRequest> pendingRequests;
+    QHash<QNetworkReply*, PendingRequest> runningRequests;
+    int maxConcurrentRequests;
+    QAtomicInt lastRequestId;
+    int coalescedRequests;
+    struct TokenBucket {
+        double tokens;
+        QDateTime lastRefill;
+    };
+    QHash<QString, TokenBucket> buckets;
+    double requestsPerSecond;
+    int burstSize;
+    bool hasToken(const QString &host, const QDateTime &now, QDateTime &wakeUp);
+    int queueDepth;
+    int maxQueueDepth;
+    int startedRequests[PriorityCount];
+    qint64 totalQueueWait[PriorityCount];
+    int maxQueueWait[PriorityCount];
+    QTimer *wakeUpTimer;
+
+/*
+ * Requests which fail because of the server or the network are retried
+ * with exponential backoff and jitter, honouring Retry-After.
+ * After breakerThreshold consecutive failures the circuit for that host
+ * is opened: its requests stay queued until a single probe request
+ * gets through again.
+ *
+ */
+    struct HostState {
+        int failures;
+        QDateTime openUntil;
+        int openInterval;
+        bool probing;
+    };
+    QHash<QString, HostState> hosts;
+    int maxRetries;
+    int maxRetryDelay;
+    int retriedRequests;
+    int failedRequests;
+    int breakerThreshold;
+    int breakerInterval;
+    bool isRetryable(QNetworkReply *reply);
+    int getRetryDelay(QNetworkReply *reply, int attempts);
+    void retryRequest(QNetworkReply *reply, const PendingRequest &pendingRequest);
+    bool acquireHost(const QString &host, const QDateTime &now, QDateTime &wakeUp);
+    void releaseHost(const QString &host);
+    void recordHostSuccess(const QString &host);
+    void recordHostFailure(const QString &host);
+    void countFailure();
+
+/*
+ * Running replies are aborted after requestTimeout, or when no data
+ * has arrived for stallTimeout, and then retried like other network
+ * errors. Requests can also be cancelled, eg: a superseded refresh.
+ *
+ */
+    QTimer *timeoutTimer;
+    int requestTimeout;
+    int stallTimeout;
+    int timedOutRequests;
+    OBScache *cache;
+    OBScacheManifest *manifest;
+    OBSmetaCache *metaCache;
+    OBScookieJar *cookieJar;
+
+/*
+ * Connections are opened (and their TLS handshakes done) when logging
+ * in, by a few requests sent along with the login. All the requests
+ * share one TLS configuration, so that they use those connections.
+ *
+ */
+    int warmUpConnections;
+    QSslConfiguration sslConfiguration;
+    void watchConnection(QNetworkReply *reply);
+    OBStimings timings;
+    void recordTimings(QNetworkReply *reply, const PendingRequest &pendingRequest);
+
+/*
+ * Watched projects are long-polled with _result?oldstate=<hash>,
+ * which returns as soon as the build state differs from the given one.
+ * Each reply re-arms the watch with the state it returned. Watches
+ * are not re-armed while logged out, and a long-poll which has been
+ * silent for watchTimeout is aborted and sent again.
+ *
+ */
+    struct Watch {
+        QString filters;
+        QString state;
+        bool parsing;
+        QDateTime deadline;
+    };
+    QNetworkAccessManager* watchManager;
+    QHash<QString, Watch> watches;
+    QHash<QNetworkReply*, QString> watchReplies;
+    int watchRetryInterval;
+    int watchTimeout;
+    QString createResultFilters(const QStringList &packages,
+                                const QStringList &repositories, const QStringList &archs);
+    void startWatch(const QString &project);
     QString curUsername;
     QString curPassword;
-    QString data;
     bool authenticated;
-    OBSxmlReader *xmlReader;
-    QList<OBSrequest*> obsRequests;
+    int requestNumber;
 
 };
 
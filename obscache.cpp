@@ -0,0 +1,117 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obscache.h"
+
+OBScache::OBScache()
+{
+    hits = 0;
+    misses = 0;
+    savedBytes = 0;
+//    The cost of an entry is its size in bytes (32 MB by default)
+    setMaxSize(32*1024*1024);
+}
+
+void OBScache::setMaxSize(int maxSize)
+{
+    entries.setMaxCost(maxSize);
+}
+
+void OBScache::prepareRequest(QNetworkRequest &request)
+{
+    CacheEntry *entry = entries.object(request.url().toString());
+
+    if (entry) {
+        if (!entry->eTag.isEmpty()) {
+            request.setRawHeader("If-None-Match", entry->eTag);
+        }
+        if (!entry->lastModified.isEmpty()) {
+            request.setRawHeader("If-Modified-Since", entry->lastModified);
+        }
+    }
+}
+
+bool OBScache::isCacheable(QNetworkReply *reply)
+{
+    int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return httpStatusCode == 200 &&
+            (reply->hasRawHeader("ETag") || reply->hasRawHeader("Last-Modified"));
+}
+
+bool OBScache::isNotModified(QNetworkReply *reply)
+{
+    int httpStatusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return httpStatusCode == 304 && entries.contains(reply->url().toString());
+}
+
+QByteArray OBScache::getData(QNetworkReply *reply)
+{
+    QString url = reply->url().toString();
+    CacheEntry *entry = entries.object(url);
+
+    if (!entry) {
+        qDebug() << "Cache entry not found for" << url;
+        return QByteArray();
+    }
+
+    mutex.lock();
+    hits++;
+    savedBytes += entry->data.size();
+    mutex.unlock();
+    qDebug() << "Cache hit:" << url << "(" << entry->data.size() << "bytes )";
+    return entry->data;
+}
+
+void OBScache::insert(QNetworkReply *reply, const QByteArray &body)
+{
+    QString url = reply->url().toString();
+    mutex.lock();
+    misses++;
+    mutex.unlock();
+
+    if (isCacheable(reply)) {
+        CacheEntry *entry = new CacheEntry;
+        entry->eTag = reply->rawHeader("ETag");
+        entry->lastModified = reply->rawHeader("Last-Modified");
+        entry->data = body;
+//        QCache takes ownership and drops entries bigger than maxCost
+        entries.insert(url, entry, qMax(1, body.size()));
+    } else {
+        entries.remove(url);
+    }
+}
+
+int OBScache::getHits() const
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+int OBScache::getMisses() const
+{
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+qint64 OBScache::getSavedBytes() const
+{
+    QMutexLocker locker(&mutex);
+    return savedBytes;
+}
@@ -0,0 +1,67 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSCACHE_H
+#define OBSCACHE_H
+
+#include <QCache>
+#include <QByteArray>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QMutex>
+#include <QDebug>
+
+/*
+ * Conditional request cache. The validators (ETag/Last-Modified) of
+ * every reply are kept along with its body, so that the next request
+ * for the same URL can be sent with If-None-Match/If-Modified-Since.
+ * When the server answers 304 Not Modified, the cached body is used.
+ * The cache is used by the network thread only, but its counters are
+ * read from the GUI thread too and are guarded by mutex.
+ *
+ */
+class OBScache
+{
+public:
+    OBScache();
+    void prepareRequest(QNetworkRequest &request);
+    bool isCacheable(QNetworkReply *reply);
+    bool isNotModified(QNetworkReply *reply);
+    QByteArray getData(QNetworkReply *reply);
+    void insert(QNetworkReply *reply, const QByteArray &body);
+    void setMaxSize(int maxSize);
+    int getHits() const;
+    int getMisses() const;
+    qint64 getSavedBytes() const;
+
+private:
+    struct CacheEntry {
+        QByteArray eTag;
+        QByteArray lastModified;
+        QByteArray data;
+    };
+    QCache<QString, CacheEntry> entries;
+    mutable QMutex mutex;
+    int hits;
+    int misses;
+    qint64 savedBytes;
+};
+
+#endif // OBSCACHE_H
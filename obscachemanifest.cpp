@@ -0,0 +1,164 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obscachemanifest.h"
+
+static const quint32 manifestVersion = 1;
+
+OBScacheManifest::OBScacheManifest()
+{
+//    Projects come and go less often than packages
+    ttls[ProjectList] = 24*60*60;
+    ttls[PackageList] = 60*60;
+    ttls[ProjectMeta] = 24*60*60;
+}
+
+void OBScacheManifest::load(const QString &fileName)
+{
+    QMutexLocker locker(&mutex);
+    this->fileName = fileName;
+    entries.clear();
+
+    QFile file(QDir(OBSxmlReader::getDataDir()).filePath(fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    quint32 version;
+    in >> version;
+    if (version != manifestVersion) {
+        qDebug() << "OBScacheManifest: ignoring" << fileName << "version" << version;
+        return;
+    }
+
+    quint32 count;
+    in >> count;
+    for (quint32 i=0; i<count && in.status() == QDataStream::Ok; i++) {
+        QString resource;
+        Entry entry;
+        in >> resource >> entry.fetchedAt >> entry.eTag >> entry.lastModified >> entry.size;
+        entries.insert(resource, entry);
+    }
+    qDebug() << "OBScacheManifest: loaded" << entries.size() << "entries from" << fileName;
+}
+
+void OBScacheManifest::save()
+{
+//    Called with the mutex locked
+    QString filePath = QDir(OBSxmlReader::getDataDir()).filePath(fileName);
+    QDir dir(QFileInfo(filePath).absolutePath());
+    if (!dir.exists()) {
+        dir.mkpath(dir.absolutePath());
+    }
+    QFile file(filePath + ".part");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error: Cannot write file" << file.fileName() << "(" << file.errorString() << ")";
+        return;
+    }
+
+    QDataStream out(&file);
+    out << manifestVersion << quint32(entries.size());
+    QMapIterator<QString, Entry> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        const Entry &entry = i.value();
+        out << i.key() << entry.fetchedAt << entry.eTag << entry.lastModified << entry.size;
+    }
+    file.close();
+
+    QFile::remove(filePath);
+    if (!file.rename(filePath)) {
+        qDebug() << "Error: Cannot rename" << file.fileName() << "to" << filePath;
+    }
+}
+
+OBScacheManifest::ResourceType OBScacheManifest::getResourceType(const QString &resource)
+{
+    QString name = QFileInfo(resource).fileName();
+    if (name == "projects.xml") {
+        return ProjectList;
+    } else if (name.endsWith("_meta.xml")) {
+        return ProjectMeta;
+    }
+    return PackageList;
+}
+
+void OBScacheManifest::setTtl(ResourceType type, int seconds)
+{
+    QMutexLocker locker(&mutex);
+    ttls[type] = seconds;
+}
+
+int OBScacheManifest::getTtl(ResourceType type) const
+{
+    QMutexLocker locker(&mutex);
+    return ttls[type];
+}
+
+bool OBScacheManifest::isStale(const QString &resource) const
+{
+//    Files cached before the manifest existed are stale
+    QMutexLocker locker(&mutex);
+    if (!entries.contains(resource)) {
+        return true;
+    }
+    int age = entries.value(resource).fetchedAt.secsTo(QDateTime::currentDateTime());
+    return age < 0 || age >= ttls[getResourceType(resource)];
+}
+
+void OBScacheManifest::prepareRequest(const QString &resource, QNetworkRequest &request) const
+{
+//    Without the file a 304 Not Modified would leave us with nothing
+    QMutexLocker locker(&mutex);
+    if (!entries.contains(resource) ||
+            !QFile::exists(QDir(OBSxmlReader::getDataDir()).filePath(resource))) {
+        return;
+    }
+
+    const Entry &entry = entries[resource];
+    if (!entry.eTag.isEmpty()) {
+        request.setRawHeader("If-None-Match", entry.eTag);
+    }
+    if (!entry.lastModified.isEmpty()) {
+        request.setRawHeader("If-Modified-Since", entry.lastModified);
+    }
+}
+
+void OBScacheManifest::update(const QString &resource, QNetworkReply *reply, qint64 size)
+{
+    QMutexLocker locker(&mutex);
+    Entry entry;
+    entry.fetchedAt = QDateTime::currentDateTime();
+    entry.eTag = reply->rawHeader("ETag");
+    entry.lastModified = reply->rawHeader("Last-Modified");
+    entry.size = size;
+    entries.insert(resource, entry);
+    save();
+}
+
+void OBScacheManifest::touch(const QString &resource)
+{
+//    The server confirmed that the cached file is still valid
+    QMutexLocker locker(&mutex);
+    if (entries.contains(resource)) {
+        entries[resource].fetchedAt = QDateTime::currentDateTime();
+        save();
+    }
+}
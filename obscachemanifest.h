@@ -0,0 +1,76 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSCACHEMANIFEST_H
+#define OBSCACHEMANIFEST_H
+
+#include <QMap>
+#include <QMutex>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QDebug>
+#include "obsxmlreader.h"
+
+/*
+ * Freshness of the listings cached in the data directory (projects,
+ * package lists and _meta files). For each file it keeps when it was
+ * fetched, its validators (ETag/Last-Modified) and its size, so that
+ * a stale file can be revalidated with a conditional request while
+ * the cached copy is still being used. How long a file stays fresh
+ * (TTL) depends on its resource type.
+ *
+ * The manifest is saved with QDataStream whenever it changes. It is
+ * updated on the worker thread and read from the GUI.
+ *
+ */
+class OBScacheManifest
+{
+public:
+    enum ResourceType { ProjectList, PackageList, ProjectMeta, ResourceTypeCount };
+    OBScacheManifest();
+    void load(const QString &fileName);
+    static ResourceType getResourceType(const QString &resource);
+    void setTtl(ResourceType type, int seconds);
+    int getTtl(ResourceType type) const;
+    bool isStale(const QString &resource) const;
+    void prepareRequest(const QString &resource, QNetworkRequest &request) const;
+    void update(const QString &resource, QNetworkReply *reply, qint64 size);
+    void touch(const QString &resource);
+
+private:
+    struct Entry {
+        QDateTime fetchedAt;
+        QByteArray eTag;
+        QByteArray lastModified;
+        qint64 size;
+    };
+    QMap<QString, Entry> entries;
+    QString fileName;
+    int ttls[ResourceTypeCount];
+    mutable QMutex mutex;
+    void save();
+};
+
+#endif // OBSCACHEMANIFEST_H
@@ -0,0 +1,100 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obscookiejar.h"
+
+OBScookieJar::OBScookieJar(const QString &fileName, QObject *parent) :
+    QNetworkCookieJar(parent)
+{
+    this->fileName = fileName;
+    load();
+}
+
+QList<QNetworkCookie> OBScookieJar::cookiesForUrl(const QUrl &url) const
+{
+    QMutexLocker locker(&mutex);
+    return QNetworkCookieJar::cookiesForUrl(url);
+}
+
+bool OBScookieJar::setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url)
+{
+    QMutexLocker locker(&mutex);
+    QList<QNetworkCookie> oldCookies = allCookies();
+    bool added = QNetworkCookieJar::setCookiesFromUrl(cookieList, url);
+
+//    The same cookies are sent back with most replies,
+//    the file is only written when something has changed
+    if (added && allCookies() != oldCookies) {
+        save();
+    }
+    return added;
+}
+
+bool OBScookieJar::hasCookiesFor(const QUrl &url) const
+{
+    return !cookiesForUrl(url).isEmpty();
+}
+
+void OBScookieJar::clear()
+{
+    QMutexLocker locker(&mutex);
+    setAllCookies(QList<QNetworkCookie>());
+    QFile::remove(fileName);
+}
+
+void OBScookieJar::load()
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+//    One cookie per line, as in a Set-Cookie header
+    QDateTime now = QDateTime::currentDateTime();
+    QList<QNetworkCookie> cookies;
+    while (!file.atEnd()) {
+        foreach (const QNetworkCookie &cookie, QNetworkCookie::parseCookies(file.readLine().trimmed())) {
+            if (cookie.isSessionCookie() || cookie.expirationDate() > now) {
+                cookies.append(cookie);
+            }
+        }
+    }
+    setAllCookies(cookies);
+    qDebug() << "Cookies loaded:" << cookies.size();
+}
+
+void OBScookieJar::save()
+{
+    QDir dir(QFileInfo(fileName).absolutePath());
+    if (!dir.exists()) {
+        dir.mkpath(dir.absolutePath());
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error: Cannot write file" << fileName << "(" << file.errorString() << ")";
+        return;
+    }
+//    It holds the session, only the user may read it
+    file.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+    foreach (const QNetworkCookie &cookie, allCookies()) {
+        file.write(cookie.toRawForm(QNetworkCookie::Full) + "\n");
+    }
+}
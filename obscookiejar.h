@@ -0,0 +1,59 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSCOOKIEJAR_H
+#define OBSCOOKIEJAR_H
+
+#include <QNetworkCookieJar>
+#include <QNetworkCookie>
+#include <QMutex>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+
+/*
+ * Cookie jar which is kept on disk, so that the OBS session cookie
+ * survives restarts and no authentication round trip is needed while
+ * the session is valid. Session cookies (with no expiration date) are
+ * kept as well. The jar is shared by OBSaccess' managers and can be
+ * queried from the GUI thread, so it is guarded by a mutex.
+ *
+ */
+class OBScookieJar : public QNetworkCookieJar
+{
+    Q_OBJECT
+
+public:
+    explicit OBScookieJar(const QString &fileName, QObject *parent = 0);
+    QList<QNetworkCookie> cookiesForUrl(const QUrl &url) const;
+    bool setCookiesFromUrl(const QList<QNetworkCookie> &cookieList, const QUrl &url);
+    bool hasCookiesFor(const QUrl &url) const;
+    void clear();
+
+private:
+    QString fileName;
+    mutable QMutex mutex;
+    void load();
+    void save();
+};
+
+#endif // OBSCOOKIEJAR_H
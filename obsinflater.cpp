@@ -0,0 +1,114 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obsinflater.h"
+
+OBSinflater::OBSinflater()
+{
+    finished = false;
+    error = !init(false);
+}
+
+OBSinflater::~OBSinflater()
+{
+    inflateEnd(&stream);
+}
+
+bool OBSinflater::init(bool raw)
+{
+//    With 15+32 window bits zlib detects both the gzip and the zlib
+//    header. Some servers send "deflate" without a header (raw).
+    this->raw = raw;
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+    return inflateInit2(&stream, raw ? -MAX_WBITS : MAX_WBITS + 32) == Z_OK;
+}
+
+bool OBSinflater::isSupported(const QByteArray &contentEncoding)
+{
+    QByteArray encoding = contentEncoding.trimmed().toLower();
+    return encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate";
+}
+
+QByteArray OBSinflater::inflate(const QByteArray &data)
+{
+    QByteArray output;
+    if (error || finished || data.isEmpty()) {
+        return output;
+    }
+
+    bool firstChunk = stream.total_in == 0;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+    stream.avail_in = data.size();
+
+    char buffer[16384];
+//    zlib may still hold output when the input has been consumed, the
+//    buffer is drained until inflate() leaves some of it unused
+    for (;;) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        int ret = ::inflate(&stream, Z_NO_FLUSH);
+
+        if (ret == Z_DATA_ERROR && firstChunk && !raw && stream.total_out == 0) {
+//            No zlib/gzip header, start again as raw deflate
+            inflateEnd(&stream);
+            if (!init(true)) {
+                error = true;
+                break;
+            }
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+            stream.avail_in = data.size();
+            continue;
+        }
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            qDebug() << "OBSinflater: error" << ret << (stream.msg ? stream.msg : "");
+            error = true;
+            break;
+        }
+
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+        if (ret == Z_STREAM_END) {
+            finished = true;
+            break;
+        }
+        if (stream.avail_out != 0) {
+//            All the input has been used, wait for more
+            break;
+        }
+    }
+    return output;
+}
+
+void OBSinflater::endStream()
+{
+//    The body has ended, a truncated stream is an error
+    if (!error && !finished) {
+        qDebug() << "OBSinflater: stream ended before its end marker";
+        error = true;
+    }
+}
+
+bool OBSinflater::hasError()
+{
+    return error;
+}
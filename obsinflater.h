@@ -0,0 +1,54 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSINFLATER_H
+#define OBSINFLATER_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <zlib.h>
+
+/*
+ * Streaming decompression of gzip/deflate bodies. QNAM only inflates
+ * replies itself when it has set Accept-Encoding, and then it does so
+ * once the whole body has arrived. Each chunk given to inflate() is
+ * decompressed right away, so that it can be fed to the parser without
+ * keeping the compressed or the decompressed body around.
+ *
+ */
+class OBSinflater
+{
+public:
+    OBSinflater();
+    ~OBSinflater();
+    static bool isSupported(const QByteArray &contentEncoding);
+    QByteArray inflate(const QByteArray &data);
+    void endStream();
+    bool hasError();
+
+private:
+    z_stream stream;
+    bool raw;
+    bool finished;
+    bool error;
+    bool init(bool raw);
+};
+
+#endif // OBSINFLATER_H
@@ -0,0 +1,201 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obslistindex.h"
+#include <cstring>
+
+static const char indexMagic[4] = { 'O', 'B', 'S', 'I' };
+static const quint32 indexVersion = 1;
+static const int headerSize = 12;
+
+OBSlistIndex::OBSlistIndex()
+{
+    data = NULL;
+    entries = 0;
+    offsets = NULL;
+    strings = NULL;
+}
+
+OBSlistIndex::~OBSlistIndex()
+{
+    if (data) {
+        file.unmap(data);
+    }
+}
+
+QByteArray OBSlistIndex::compile(const QStringList &list)
+{
+    QList<QByteArray> sortedList;
+    foreach (const QString &entry, list) {
+        sortedList.append(entry.toUtf8());
+    }
+    qSort(sortedList);
+
+    QByteArray stringBuffer;
+    QVector<quint32> offsetTable;
+    for (int i=0; i<sortedList.size(); i++) {
+        if (i > 0 && sortedList.at(i) == sortedList.at(i-1)) {
+            continue;
+        }
+        offsetTable.append(stringBuffer.size());
+        stringBuffer.append(sortedList.at(i));
+    }
+    quint32 count = offsetTable.size();
+    offsetTable.append(stringBuffer.size());
+
+    QByteArray index;
+    index.append(indexMagic, sizeof(indexMagic));
+    index.append(reinterpret_cast<const char*>(&indexVersion), sizeof(quint32));
+    index.append(reinterpret_cast<const char*>(&count), sizeof(quint32));
+    index.append(reinterpret_cast<const char*>(offsetTable.constData()),
+                 offsetTable.size()*sizeof(quint32));
+    index.append(stringBuffer);
+    return index;
+}
+
+bool OBSlistIndex::build(const QString &fileName, const QStringList &list)
+{
+//    Written to <fileName>.part first, like the listings
+    QString filePath = QDir(OBSxmlReader::getDataDir()).filePath(fileName);
+    QDir dir(QFileInfo(filePath).absolutePath());
+    if (!dir.exists()) {
+        dir.mkpath(dir.absolutePath());
+    }
+    QFile file(filePath + ".part");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error: Cannot write file" << file.fileName() << "(" << file.errorString() << ")";
+        return false;
+    }
+    file.write(compile(list));
+    file.close();
+
+    QFile::remove(filePath);
+    if (!file.rename(filePath)) {
+        qDebug() << "Error: Cannot rename" << file.fileName() << "to" << filePath;
+        return false;
+    }
+    qDebug() << "OBSlistIndex: built" << fileName << "from" << list.size() << "entries";
+    return true;
+}
+
+bool OBSlistIndex::open(const QString &fileName)
+{
+    file.setFileName(QDir(OBSxmlReader::getDataDir()).filePath(fileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (size >= headerSize) {
+        data = file.map(0, size);
+    }
+    if (!data || !load(data, size)) {
+        qDebug() << "Error: Invalid index" << file.fileName();
+        if (data) {
+            file.unmap(data);
+            data = NULL;
+        }
+        return false;
+    }
+    return true;
+}
+
+void OBSlistIndex::setList(const QStringList &list)
+{
+    buffer = compile(list);
+    load(reinterpret_cast<const uchar*>(buffer.constData()), buffer.size());
+}
+
+bool OBSlistIndex::load(const uchar *bytes, qint64 size)
+{
+    entries = 0;
+    if (size < headerSize) {
+        return false;
+    }
+    const quint32 *header = reinterpret_cast<const quint32*>(bytes + sizeof(indexMagic));
+    quint32 count = header[1];
+    qint64 stringsStart = headerSize + (qint64(count) + 1)*sizeof(quint32);
+    if (memcmp(bytes, indexMagic, sizeof(indexMagic)) != 0 || header[0] != indexVersion ||
+            stringsStart > size) {
+        return false;
+    }
+
+    offsets = reinterpret_cast<const quint32*>(bytes + headerSize);
+    strings = reinterpret_cast<const char*>(bytes + stringsStart);
+    if (stringsStart + offsets[count] > size) {
+        return false;
+    }
+    entries = count;
+    return true;
+}
+
+int OBSlistIndex::count() const
+{
+    return entries;
+}
+
+QString OBSlistIndex::at(int i) const
+{
+    return QString::fromUtf8(strings + offsets[i], offsets[i+1] - offsets[i]);
+}
+
+int OBSlistIndex::comparePrefix(int i, const QByteArray &prefix) const
+{
+//    <0 if the entry sorts before the entries starting with prefix,
+//    0 if it starts with it and >0 if it sorts after them
+    int length = offsets[i+1] - offsets[i];
+    int result = memcmp(strings + offsets[i], prefix.constData(), qMin(length, prefix.size()));
+    if (result == 0 && length < prefix.size()) {
+        return -1;
+    }
+    return result;
+}
+
+int OBSlistIndex::lowerBound(const QByteArray &prefix) const
+{
+//    First entry starting with prefix (or after them)
+    int first = 0;
+    int last = entries;
+    while (first < last) {
+        int middle = first + (last - first)/2;
+        if (comparePrefix(middle, prefix) < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+int OBSlistIndex::upperBound(const QByteArray &prefix) const
+{
+//    First entry after the ones starting with prefix
+    int first = 0;
+    int last = entries;
+    while (first < last) {
+        int middle = first + (last - first)/2;
+        if (comparePrefix(middle, prefix) <= 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
@@ -0,0 +1,68 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSLISTINDEX_H
+#define OBSLISTINDEX_H
+
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <QDebug>
+#include "obsxmlreader.h"
+
+/*
+ * A listing (eg: projects) compiled into a sorted binary index, which
+ * is memory-mapped instead of parsing the XML file again:
+ *
+ *   "OBSI" | version | count | offsets[count+1] | UTF-8 strings
+ *
+ * The header and the offsets are quint32 in host byte order, as the
+ * file is a local cache. Entries are sorted by their UTF-8 bytes, so
+ * the entries starting with a prefix are found with a binary search.
+ * Short lists (eg: repositories) are compiled in memory with setList().
+ *
+ */
+class OBSlistIndex
+{
+public:
+    OBSlistIndex();
+    ~OBSlistIndex();
+    static bool build(const QString &fileName, const QStringList &list);
+    bool open(const QString &fileName);
+    void setList(const QStringList &list);
+    int count() const;
+    QString at(int i) const;
+    int lowerBound(const QByteArray &prefix) const;
+    int upperBound(const QByteArray &prefix) const;
+
+private:
+    static QByteArray compile(const QStringList &list);
+    bool load(const uchar *bytes, qint64 size);
+    int comparePrefix(int i, const QByteArray &prefix) const;
+    QFile file;
+    uchar *data;
+    QByteArray buffer;
+    quint32 entries;
+    const quint32 *offsets;
+    const char *strings;
+};
+
+#endif // OBSLISTINDEX_H
@@ -0,0 +1,98 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obslistmodel.h"
+
+OBSlistModel::OBSlistModel(QObject *parent) :
+    QAbstractListModel(parent)
+{
+    listIndex = NULL;
+    first = 0;
+    last = 0;
+}
+
+OBSlistModel::~OBSlistModel()
+{
+    delete listIndex;
+}
+
+void OBSlistModel::setIndex(OBSlistIndex *index)
+{
+//    The model takes ownership of the index
+    beginResetModel();
+    delete listIndex;
+    listIndex = index;
+    updateRange();
+    endResetModel();
+}
+
+void OBSlistModel::setList(const QStringList &list)
+{
+    OBSlistIndex *index = new OBSlistIndex();
+    index->setList(list);
+    setIndex(index);
+}
+
+QString OBSlistModel::getPrefix() const
+{
+    return prefix;
+}
+
+void OBSlistModel::setPrefix(const QString &prefix)
+{
+    if (prefix == this->prefix) {
+        return;
+    }
+    beginResetModel();
+    this->prefix = prefix;
+    updateRange();
+    endResetModel();
+}
+
+void OBSlistModel::updateRange()
+{
+    if (!listIndex) {
+        first = last = 0;
+    } else if (prefix.isEmpty()) {
+        first = 0;
+        last = listIndex->count();
+    } else {
+        QByteArray prefixBytes = prefix.toUtf8();
+        first = listIndex->lowerBound(prefixBytes);
+        last = listIndex->upperBound(prefixBytes);
+    }
+}
+
+int OBSlistModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !listIndex) {
+        return 0;
+    }
+    return last - first;
+}
+
+QVariant OBSlistModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount() ||
+            (role != Qt::DisplayRole && role != Qt::EditRole)) {
+        return QVariant();
+    }
+    return listIndex->at(first + index.row());
+}
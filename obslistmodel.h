@@ -0,0 +1,59 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSLISTMODEL_H
+#define OBSLISTMODEL_H
+
+#include <QAbstractListModel>
+#include "obslistindex.h"
+
+/*
+ * Read-only model over an OBSlistIndex. The strings are only
+ * decoded when a view (eg: QCompleter's popup) asks for them.
+ * setPrefix() narrows the rows to the range of entries starting with
+ * the prefix (two binary searches), so a QCompleter in
+ * UnfilteredPopupCompletion mode doesn't have to filter the list.
+ *
+ */
+class OBSlistModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit OBSlistModel(QObject *parent = 0);
+    ~OBSlistModel();
+    void setIndex(OBSlistIndex *index);
+    void setList(const QStringList &list);
+    QString getPrefix() const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+public slots:
+    void setPrefix(const QString &prefix);
+
+private:
+    OBSlistIndex *listIndex;
+    QString prefix;
+    int first;
+    int last;
+    void updateRange();
+};
+
+#endif // OBSLISTMODEL_H
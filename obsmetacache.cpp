@@ -0,0 +1,117 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obsmetacache.h"
+
+static const quint32 cacheVersion = 2;
+
+OBSmetaCache::OBSmetaCache()
+{
+}
+
+QString OBSmetaCache::getCacheFileName(const QString &fileName)
+{
+//    <project>_meta.xml -> <project>_meta.dat
+    return QFileInfo(fileName).path() + "/" + QFileInfo(fileName).completeBaseName() + ".dat";
+}
+
+OBSprojectMeta OBSmetaCache::get(const QString &fileName)
+{
+    QDir dataDir(OBSxmlReader::getDataDir());
+    QFileInfo xmlInfo(dataDir.filePath(fileName));
+    if (!xmlInfo.exists()) {
+        return OBSprojectMeta();
+    }
+
+//    Modification times can have a resolution of a second, a _meta
+//    rewritten within the same second is told apart by its size
+    QMutexLocker locker(&mutex);
+    if (entries.contains(fileName) && entries.value(fileName).lastModified == xmlInfo.lastModified() &&
+            entries.value(fileName).size == xmlInfo.size()) {
+        return entries.value(fileName).projectMeta;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    CacheEntry entry;
+    entry.lastModified = xmlInfo.lastModified();
+    entry.size = xmlInfo.size();
+    QString cacheFileName = getCacheFileName(fileName);
+    if (readCache(cacheFileName, entry)) {
+        qDebug() << "OBSmetaCache: read" << cacheFileName << "in" << timer.elapsed() << "ms";
+    } else {
+        entry.projectMeta = OBSxmlReader::readProjectMeta(fileName);
+        writeCache(cacheFileName, entry);
+        qDebug() << "OBSmetaCache: parsed" << fileName << "in" << timer.elapsed() << "ms";
+    }
+    entries.insert(fileName, entry);
+    return entry.projectMeta;
+}
+
+void OBSmetaCache::invalidate(const QString &fileName)
+{
+//    Called when the XML file has been replaced
+    QMutexLocker locker(&mutex);
+    entries.remove(fileName);
+    QFile::remove(QDir(OBSxmlReader::getDataDir()).filePath(getCacheFileName(fileName)));
+}
+
+bool OBSmetaCache::readCache(const QString &cacheFileName, CacheEntry &entry)
+{
+    QFile file(QDir(OBSxmlReader::getDataDir()).filePath(cacheFileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 version;
+    in >> version;
+    if (version != cacheVersion) {
+        return false;
+    }
+//    The .dat belongs to the XML file it was parsed from
+    qint64 lastModified;
+    qint64 size;
+    in >> lastModified >> size;
+    if (lastModified != entry.lastModified.toMSecsSinceEpoch() || size != entry.size) {
+        return false;
+    }
+    in >> entry.projectMeta;
+    return in.status() == QDataStream::Ok;
+}
+
+void OBSmetaCache::writeCache(const QString &cacheFileName, const CacheEntry &entry)
+{
+//    Written to <cacheFileName>.part first, like the listings
+    QString filePath = QDir(OBSxmlReader::getDataDir()).filePath(cacheFileName);
+    QFile file(filePath + ".part");
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Error: Cannot write file" << file.fileName() << "(" << file.errorString() << ")";
+        return;
+    }
+    QDataStream out(&file);
+    out << cacheVersion << qint64(entry.lastModified.toMSecsSinceEpoch()) << entry.size
+        << entry.projectMeta;
+    file.close();
+
+    QFile::remove(filePath);
+    if (!file.rename(filePath)) {
+        qDebug() << "Error: Cannot rename" << file.fileName() << "to" << filePath;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSMETACACHE_H
+#define OBSMETACACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QDebug>
+#include "obsprojectmeta.h"
+#include "obsxmlreader.h"
+
+/*
+ * Parsed _meta files. Each <project>_meta.xml is parsed once into an
+ * OBSprojectMeta, which is kept in memory and written next to it as
+ * <project>_meta.dat (QDataStream), so that it isn't parsed again
+ * after a restart either. An entry is valid as long as the XML file
+ * has the modification time and size it was parsed with; OBSaccess
+ * also invalidates it when it downloads a new _meta.
+ *
+ */
+class OBSmetaCache
+{
+public:
+    OBSmetaCache();
+    OBSprojectMeta get(const QString &fileName);
+    void invalidate(const QString &fileName);
+
+private:
+    struct CacheEntry {
+        QDateTime lastModified;
+        qint64 size;
+        OBSprojectMeta projectMeta;
+    };
+    QHash<QString, CacheEntry> entries;
+    QMutex mutex;
+    static QString getCacheFileName(const QString &fileName);
+    static bool readCache(const QString &cacheFileName, CacheEntry &entry);
+    static void writeCache(const QString &cacheFileName, const CacheEntry &entry);
+};
+
+#endif // OBSMETACACHE_H
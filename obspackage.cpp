@@ -20,36 +20,116 @@
 
 #include "obspackage.h"
 
-OBSpackage::OBSpackage()
+class OBSpackageData : public QSharedData
+{
+public:
+    QString project;
+    QString repository;
+    QString arch;
+    QString name;
+    OBSpackage::Status status;
+    QString otherStatus;
+    QString details;
+};
+
+// Same order as OBSpackage::Status
+static const char* const statusNames[] = {
+    "", "unknown", "succeeded", "failed", "unresolvable", "broken", "blocked",
+    "dispatching", "scheduled", "building", "signing", "finished",
+    "disabled", "excluded", "locked", "deleting"
+};
+
+OBSpackage::OBSpackage() : d(new OBSpackageData)
+{
+    d->status = NoStatus;
+}
+
+OBSpackage::OBSpackage(const OBSpackage &other) : d(other.d)
+{
+}
+
+OBSpackage::~OBSpackage()
 {
 }
 
+OBSpackage &OBSpackage::operator=(const OBSpackage &other)
+{
+    d = other.d;
+    return *this;
+}
+
 void OBSpackage::setName(const QString& name)
 {
-    this->name = name;
+    d->name = name;
 }
 
-QString OBSpackage::getName()
+QString OBSpackage::getName() const
 {
-    return name;
+    return d->name;
 }
 
 void OBSpackage::setStatus(const QString& status)
 {
-    this->status = status;
+    for (int i=0; i<OtherStatus; i++) {
+        if (status == QLatin1String(statusNames[i])) {
+            d->status = static_cast<Status>(i);
+            d->otherStatus.clear();
+            return;
+        }
+    }
+    d->status = OtherStatus;
+    d->otherStatus = status;
+}
+
+OBSpackage::Status OBSpackage::getStatusCode() const
+{
+    return d->status;
 }
 
-QString OBSpackage::getStatus()
+QString OBSpackage::getStatus() const
 {
-    return status;
+    if (d->status == OtherStatus) {
+        return d->otherStatus;
+    }
+    return QLatin1String(statusNames[d->status]);
 }
 
 void OBSpackage::setDetails(const QString& details)
 {
-    this->details = details;
+    d->details = details;
+}
+
+QString OBSpackage::getDetails() const
+{
+    return d->details;
+}
+
+void OBSpackage::setProject(const QString& project)
+{
+    d->project = project;
+}
+
+QString OBSpackage::getProject() const
+{
+    return d->project;
+}
+
+void OBSpackage::setRepository(const QString& repository)
+{
+    d->repository = repository;
+}
+
+QString OBSpackage::getRepository() const
+{
+    return d->repository;
+}
+
+void OBSpackage::setArch(const QString& arch)
+{
+    d->arch = arch;
 }
 
-QString OBSpackage::getDetails()
+QString OBSpackage::getArch() const
 {
-    return details;
+    return d->arch;
 }
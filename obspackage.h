@@ -21,24 +21,50 @@
 #ifndef OBSPACKAGE_H
 #define OBSPACKAGE_H
 
-#include <QObject>
 #include <QString>
+#include <QVector>
+#include <QMetaType>
+#include <QSharedDataPointer>
 
-class OBSpackage : public QObject
+class OBSpackageData;
+
+/*
+ * OBSpackage is an implicitly shared value type, copies share their data
+ * until one of them is modified. The status code is stored as an enum,
+ * only codes we don't know about are kept as a string. Results are stored
+ * in a QVector<OBSpackage>.
+ *
+ */
+class OBSpackage
 {
 public:
     OBSpackage();
+    OBSpackage(const OBSpackage &other);
+    ~OBSpackage();
+    OBSpackage &operator=(const OBSpackage &other);
+    enum Status { NoStatus, Unknown, Succeeded, Failed, Unresolvable, Broken, Blocked,
+                  Dispatching, Scheduled, Building, Signing, Finished,
+                  Disabled, Excluded, Locked, Deleting, OtherStatus };
     void setName(const QString &);
     void setStatus(const QString &);
     void setDetails(const QString &);
-    QString getName();
-    QString getStatus();
-    QString getDetails();
+    void setProject(const QString &);
+    void setRepository(const QString &);
+    void setArch(const QString &);
+    QString getName() const;
+    Status getStatusCode() const;
+    QString getStatus() const;
+    QString getDetails() const;
+    QString getProject() const;
+    QString getRepository() const;
+    QString getArch() const;
 
 private:
-    QString name;
-    QString status;
-    QString details;
+    QSharedDataPointer<OBSpackageData> d;
 };
 
+// Results are passed from the network thread to the GUI with queued signals
+Q_DECLARE_METATYPE(OBSpackage)
+Q_DECLARE_METATYPE(QVector<OBSpackage>)
+
 #endif // OBSPACKAGE_H
@@ -0,0 +1,108 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obsprojectmeta.h"
+
+OBSprojectMeta::OBSprojectMeta()
+{
+}
+
+void OBSprojectMeta::setProject(const QString &project)
+{
+    this->project = project;
+}
+
+QString OBSprojectMeta::getProject() const
+{
+    return project;
+}
+
+void OBSprojectMeta::addRepository(const Repository &repository)
+{
+    repositories.append(repository);
+}
+
+bool OBSprojectMeta::isEmpty() const
+{
+    return repositories.isEmpty();
+}
+
+const OBSprojectMeta::Repository *OBSprojectMeta::findRepository(const QString &name) const
+{
+//    Projects have a handful of repositories, a linear search will do
+    for (int i=0; i<repositories.size(); i++) {
+        if (repositories.at(i).name == name) {
+            return &repositories.at(i);
+        }
+    }
+    return NULL;
+}
+
+QStringList OBSprojectMeta::getRepositories() const
+{
+    QStringList names;
+    foreach (const Repository &repository, repositories) {
+        names.append(repository.name);
+    }
+    return names;
+}
+
+QStringList OBSprojectMeta::getArchs(const QString &repository) const
+{
+    const Repository *found = findRepository(repository);
+    return found ? found->archs : QStringList();
+}
+
+QList<OBSprojectMeta::Path> OBSprojectMeta::getPaths(const QString &repository) const
+{
+    const Repository *found = findRepository(repository);
+    return found ? found->paths : QList<Path>();
+}
+
+QDataStream &operator<<(QDataStream &out, const OBSprojectMeta &projectMeta)
+{
+    out << projectMeta.project << quint32(projectMeta.repositories.size());
+    foreach (const OBSprojectMeta::Repository &repository, projectMeta.repositories) {
+        out << repository.name << repository.archs << quint32(repository.paths.size());
+        foreach (const OBSprojectMeta::Path &path, repository.paths) {
+            out << path.project << path.repository;
+        }
+    }
+    return out;
+}
+
+QDataStream &operator>>(QDataStream &in, OBSprojectMeta &projectMeta)
+{
+    quint32 repositoryCount;
+    projectMeta.repositories.clear();
+    in >> projectMeta.project >> repositoryCount;
+    for (quint32 i=0; i<repositoryCount && in.status() == QDataStream::Ok; i++) {
+        OBSprojectMeta::Repository repository;
+        quint32 pathCount;
+        in >> repository.name >> repository.archs >> pathCount;
+        for (quint32 j=0; j<pathCount && in.status() == QDataStream::Ok; j++) {
+            OBSprojectMeta::Path path;
+            in >> path.project >> path.repository;
+            repository.paths.append(path);
+        }
+        projectMeta.repositories.append(repository);
+    }
+    return in;
+}
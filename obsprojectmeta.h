@@ -0,0 +1,68 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSPROJECTMETA_H
+#define OBSPROJECTMETA_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDataStream>
+
+/*
+ * The topology of a project, as found in its _meta: its repositories,
+ * the arches each of them is built for and the repositories they are
+ * built against (<path project="..." repository="..."/>).
+ * Like OBSpackage, it is a value type.
+ *
+ */
+class OBSprojectMeta
+{
+public:
+    OBSprojectMeta();
+    struct Path {
+        QString project;
+        QString repository;
+    };
+    struct Repository {
+        QString name;
+        QStringList archs;
+        QList<Path> paths;
+    };
+    void setProject(const QString &);
+    void addRepository(const Repository &repository);
+    QString getProject() const;
+    bool isEmpty() const;
+    QStringList getRepositories() const;
+    QStringList getArchs(const QString &repository) const;
+    QList<Path> getPaths(const QString &repository) const;
+
+private:
+    QString project;
+    QList<Repository> repositories;
+    const Repository *findRepository(const QString &name) const;
+    friend QDataStream &operator<<(QDataStream &out, const OBSprojectMeta &projectMeta);
+    friend QDataStream &operator>>(QDataStream &in, OBSprojectMeta &projectMeta);
+};
+
+QDataStream &operator<<(QDataStream &out, const OBSprojectMeta &projectMeta);
+QDataStream &operator>>(QDataStream &in, OBSprojectMeta &projectMeta);
+
+#endif // OBSPROJECTMETA_H
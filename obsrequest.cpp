@@ -20,54 +20,138 @@
 
 #include "obsrequest.h"
 
-OBSrequest::OBSrequest()
+class OBSrequestData : public QSharedData
+{
+public:
+    int id;
+    QString otherId;
+    OBSrequest::ActionType actionType;
+    OBSrequest::State state;
+    QString otherActionType;
+    QString otherState;
+    QString sourceProject;
+    QString sourcePackage;
+    QString targetProject;
+    QString targetPackage;
+    QString requester;
+    QString date;
+    QString description;
+};
+
+// Same order as OBSrequest::ActionType
+static const char* const actionTypeNames[] = {
+    "", "submit", "delete", "add_role", "set_bugowner", "change_devel",
+    "maintenance_incident", "maintenance_release", "group"
+};
+
+// Same order as OBSrequest::State
+static const char* const stateNames[] = {
+    "", "new", "review", "accepted", "declined", "revoked",
+    "superseded", "deleted"
+};
+
+static int indexOfName(const char* const names[], int size, const QString &name)
+{
+    for (int i=0; i<size; i++) {
+        if (name == QLatin1String(names[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+OBSrequest::OBSrequest() : d(new OBSrequestData)
+{
+    d->id = 0;
+    d->actionType = NoActionType;
+    d->state = NoState;
+}
+
+OBSrequest::OBSrequest(const OBSrequest &other) : d(other.d)
+{
+}
+
+OBSrequest::~OBSrequest()
 {
 }
 
+OBSrequest &OBSrequest::operator=(const OBSrequest &other)
+{
+    d = other.d;
+    return *this;
+}
+
 void OBSrequest::setId(const QString& id)
 {
-    this->id = id;
+//    Ids are numbers, anything else is kept as it is
+    bool ok;
+    d->id = id.toInt(&ok);
+    if (ok && d->id != 0) {
+        d->otherId.clear();
+    } else {
+        qDebug() << "OBSrequest: id is not a number:" << id;
+        d->id = 0;
+        d->otherId = id;
+    }
 }
 
-QString OBSrequest::getId()
+QString OBSrequest::getId() const
 {
-    return id;
+    if (d->id == 0) {
+        return d->otherId;
+    }
+    return QString::number(d->id);
 }
 
 void OBSrequest::setActionType(const QString& actionType)
 {
-    this->actionType = actionType;
+    int index = indexOfName(actionTypeNames, OtherActionType, actionType);
+    if (index == -1) {
+        d->actionType = OtherActionType;
+        d->otherActionType = actionType;
+    } else {
+        d->actionType = static_cast<ActionType>(index);
+        d->otherActionType.clear();
+    }
 }
 
-QString OBSrequest::getActionType()
+OBSrequest::ActionType OBSrequest::getActionTypeCode() const
 {
-    return actionType;
+    return d->actionType;
+}
+
+QString OBSrequest::getActionType() const
+{
+    if (d->actionType == OtherActionType) {
+        return d->otherActionType;
+    }
+    return QLatin1String(actionTypeNames[d->actionType]);
 }
 
 void OBSrequest::setSourceProject(const QString& sourceProject)
 {
-    this->sourceProject = sourceProject;
+    d->sourceProject = sourceProject;
 }
 
-QString OBSrequest::getSourceProject()
+QString OBSrequest::getSourceProject() const
 {
-    return sourceProject;
+    return d->sourceProject;
 }
 
 void OBSrequest::setSourcePackage(const QString& sourcePackage)
 {
-    this->sourcePackage = sourcePackage;
+    d->sourcePackage = sourcePackage;
 }
 
-QString OBSrequest::getSourcePackage()
+QString OBSrequest::getSourcePackage() const
 {
-    return sourcePackage;
+    return d->sourcePackage;
 }
 
-QString OBSrequest::getSource()
+QString OBSrequest::getSource() const
 {
-    if (!sourcePackage.isEmpty()) {
-        return sourceProject + "/" + sourcePackage;
+    if (!d->sourcePackage.isEmpty()) {
+        return d->sourceProject + "/" + d->sourcePackage;
     } else {
         return "N/A";
     }
@@ -75,65 +159,80 @@ QString OBSrequest::getSource()
 
 void OBSrequest::setTargetProject(const QString& targetProject)
 {
-    this->targetProject = targetProject;
+    d->targetProject = targetProject;
 }
 
-QString OBSrequest::getTargetProject()
+QString OBSrequest::getTargetProject() const
 {
-    return targetProject;
+    return d->targetProject;
 }
 
 void OBSrequest::setTargetPackage(const QString& targetPackage)
 {
-    this->targetPackage = targetPackage;
+    d->targetPackage = targetPackage;
 }
 
-QString OBSrequest::getTargetPackage()
+QString OBSrequest::getTargetPackage() const
 {
-    return targetPackage;
+    return d->targetPackage;
 }
 
-QString OBSrequest::getTarget()
+QString OBSrequest::getTarget() const
 {
-    return targetProject + "/" + targetPackage;
+    return d->targetProject + "/" + d->targetPackage;
 }
 
 void OBSrequest::setState(const QString& state)
 {
-    this->state = state;
+    int index = indexOfName(stateNames, OtherState, state);
+    if (index == -1) {
+        d->state = OtherState;
+        d->otherState = state;
+    } else {
+        d->state = static_cast<State>(index);
+        d->otherState.clear();
+    }
+}
+
+OBSrequest::State OBSrequest::getStateCode() const
+{
+    return d->state;
 }
 
-QString OBSrequest::getState()
+QString OBSrequest::getState() const
 {
-    return state;
+    if (d->state == OtherState) {
+        return d->otherState;
+    }
+    return QLatin1String(stateNames[d->state]);
 }
 
 void OBSrequest::setRequester(const QString& requester)
 {
-    this->requester = requester;
+    d->requester = requester;
 }
 
-QString OBSrequest::getRequester()
+QString OBSrequest::getRequester() const
 {
-    return requester;
+    return d->requester;
 }
 
 void OBSrequest::setDate(const QString& date)
 {
-    this->date = date;
+    d->date = date;
 }
 
-QString OBSrequest::getDate()
+QString OBSrequest::getDate() const
 {
-    return date;
+    return d->date;
 }
 
 void OBSrequest::setDescription(const QString& description)
 {
-    this->description = description;
+    d->description = description;
 }
 
-QString OBSrequest::getDescription()
+QString OBSrequest::getDescription() const
 {
-    return description;
+    return d->description;
 }
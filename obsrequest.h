@@ -22,11 +22,33 @@
 #define OBSREQUEST_H
 
 #include <QString>
+#include <QVector>
+#include <QMetaType>
+#include <QDebug>
+#include <QSharedDataPointer>
 
+class OBSrequestData;
+
+/*
+ * OBSrequest is an implicitly shared value type, requests are stored in a
+ * QVector<OBSrequest> and copying one (eg: into a queued signal) only
+ * copies a pointer. The action type and the state are stored as enums
+ * (only unknown ones are kept as strings) and the project and user names
+ * are interned by the parser, so that requests share them.
+ *
+ */
 class OBSrequest
 {
 public:
     OBSrequest();
+    OBSrequest(const OBSrequest &other);
+    ~OBSrequest();
+    OBSrequest &operator=(const OBSrequest &other);
+    enum ActionType { NoActionType, Submit, Delete, AddRole, SetBugowner,
+                      ChangeDevel, MaintenanceIncident, MaintenanceRelease,
+                      Group, OtherActionType };
+    enum State { NoState, New, Review, Accepted, Declined, Revoked,
+                 Superseded, Deleted, OtherState };
     void setId(const QString &);
     void setActionType(const QString &);
     void setSourceProject(const QString &);
@@ -38,30 +60,26 @@ public:
     void setDate(const QString &);
     void setDescription(const QString &);
 
-    QString getId();
-    QString getActionType();
-    QString getSourceProject();
-    QString getSourcePackage();
-    QString getSource();
-    QString getTargetProject();
-    QString getTargetPackage();
-    QString getTarget();
-    QString getState();
-    QString getRequester();
-    QString getDate();
-    QString getDescription();
+    QString getId() const;
+    ActionType getActionTypeCode() const;
+    QString getActionType() const;
+    QString getSourceProject() const;
+    QString getSourcePackage() const;
+    QString getSource() const;
+    QString getTargetProject() const;
+    QString getTargetPackage() const;
+    QString getTarget() const;
+    State getStateCode() const;
+    QString getState() const;
+    QString getRequester() const;
+    QString getDate() const;
+    QString getDescription() const;
 
 private:
-    QString id;
-    QString actionType;
-    QString sourceProject;
-    QString sourcePackage;
-    QString targetProject;
-    QString targetPackage;
-    QString state;
-    QString requester;
-    QString date;
-    QString description;
+    QSharedDataPointer<OBSrequestData> d;
 };
 
+Q_DECLARE_METATYPE(OBSrequest)
+Q_DECLARE_METATYPE(QVector<OBSrequest>)
+
 #endif // OBSREQUEST_H
@@ -0,0 +1,337 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obssearchindex.h"
+#include <algorithm>
+
+namespace {
+
+enum Rank { Exact, Prefix, SegmentPrefix, Substring, Typo, Fuzzy };
+
+struct Match {
+    int rank;
+    int score;
+    int length;
+    int index;
+};
+
+bool isBetterMatch(const Match &m1, const Match &m2)
+{
+    if (m1.rank != m2.rank) {
+        return m1.rank < m2.rank;
+    }
+    if (m1.score != m2.score) {
+        return m1.score > m2.score;
+    }
+    if (m1.length != m2.length) {
+        return m1.length < m2.length;
+    }
+    return m1.index < m2.index;
+}
+
+int getRank(const QString &lowerName, const QString &lowerQuery)
+{
+    if (lowerName == lowerQuery) {
+        return Exact;
+    } else if (lowerName.startsWith(lowerQuery)) {
+        return Prefix;
+    } else if (lowerName.contains(":" + lowerQuery)) {
+        return SegmentPrefix;
+    }
+    return Substring;
+}
+
+quint64 getCharMask(const QString &lowerText)
+{
+//    Which characters (modulo 64) the text contains
+    quint64 mask = 0;
+    for (int i=0; i<lowerText.size(); i++) {
+        mask |= quint64(1) << (lowerText.at(i).unicode() % 64);
+    }
+    return mask;
+}
+
+int countBits(quint64 bits)
+{
+    int count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+int getTypoDistance(const QString &lowerSegment, const QString &lowerQuery, int maxDistance,
+                    QVector<int> &before, QVector<int> &previous, QVector<int> &current)
+{
+//    Fewest edits (insert, delete, replace or swap two neighbouring
+//    characters) which turn the query into the start of the segment.
+//    Once a row is over maxDistance, maxDistance + 1 is returned.
+    int n = qMin(lowerSegment.size(), lowerQuery.size() + maxDistance);
+    for (int j=0; j<=n; j++) {
+        previous[j] = j;
+    }
+    for (int i=1; i<=lowerQuery.size(); i++) {
+        current[0] = i;
+        int rowMin = i;
+        for (int j=1; j<=n; j++) {
+            int cost = lowerQuery.at(i-1) == lowerSegment.at(j-1) ? 0 : 1;
+            int distance = qMin(qMin(previous[j], current[j-1]) + 1, previous[j-1] + cost);
+            if (i > 1 && j > 1 && lowerQuery.at(i-1) == lowerSegment.at(j-2) &&
+                    lowerQuery.at(i-2) == lowerSegment.at(j-1)) {
+                distance = qMin(distance, before[j-2] + 1);
+            }
+            current[j] = distance;
+            rowMin = qMin(rowMin, distance);
+        }
+        if (rowMin > maxDistance) {
+            return maxDistance + 1;
+        }
+        qSwap(before, previous);
+        qSwap(previous, current);
+    }
+    return *std::min_element(previous.constBegin(), previous.constBegin() + n + 1);
+}
+
+void findTypos(const QStringList &lowerNames, const QStringList &segments,
+               const QVector<quint64> &segmentMasks, const QVector<QVector<int> > &segmentNames,
+               const QString &lowerQuery, QVector<Match> &matches)
+{
+//    One edit is allowed per 8 characters of the query. Only the
+//    distinct segments of the names are compared, once those lacking
+//    more of the query's characters than that are left out.
+    int maxDistance = 1 + lowerQuery.size()/9;
+    quint64 queryMask = getCharMask(lowerQuery);
+    QSet<int> matched;
+    foreach (const Match &match, matches) {
+        matched.insert(match.index);
+    }
+
+    int rowSize = lowerQuery.size() + maxDistance + 1;
+    QVector<int> before(rowSize);
+    QVector<int> previous(rowSize);
+    QVector<int> current(rowSize);
+    for (int i=0; i<segments.size(); i++) {
+        const QString &segment = segments.at(i);
+        if (segment.size() < lowerQuery.size() - maxDistance ||
+                countBits(queryMask & ~segmentMasks.at(i)) > maxDistance) {
+            continue;
+        }
+        int distance = getTypoDistance(segment, lowerQuery, maxDistance, before, previous, current);
+        if (distance > maxDistance) {
+            continue;
+        }
+        foreach (int index, segmentNames.at(i)) {
+            if (!matched.contains(index)) {
+                matched.insert(index);
+                Match match = { Typo, -distance, lowerNames.at(index).size(), index };
+                matches.append(match);
+            }
+        }
+    }
+}
+}
+
+OBSsearchIndex::OBSsearchIndex(QObject *parent) :
+    QObject(parent)
+{
+    data = NULL;
+    generation = 0;
+}
+
+OBSsearchIndex::~OBSsearchIndex()
+{
+    foreach (QFutureWatcher<Data*> *watcher, watchers) {
+        watcher->waitForFinished();
+        delete watcher->result();
+    }
+    delete data;
+}
+
+void OBSsearchIndex::build(const QString &indexFileName)
+{
+//    A build which is still running for a previous listing
+//    is discarded when it finishes
+    clear();
+    QFutureWatcher<Data*> *watcher = new QFutureWatcher<Data*>(this);
+    watcher->setProperty("generation", generation);
+    watchers.append(watcher);
+    connect(watcher, SIGNAL(finished()), this, SLOT(buildFinished()));
+    watcher->setFuture(QtConcurrent::run(OBSsearchIndex::createData, indexFileName));
+}
+
+void OBSsearchIndex::buildFinished()
+{
+    QFutureWatcher<Data*> *watcher = static_cast<QFutureWatcher<Data*>*>(sender());
+    watchers.removeOne(watcher);
+    Data *result = watcher->result();
+    bool current = watcher->property("generation").toInt() == generation;
+    watcher->deleteLater();
+
+    if (!current) {
+        delete result;
+        return;
+    }
+    delete data;
+    data = result;
+    emit ready();
+}
+
+void OBSsearchIndex::clear()
+{
+    generation++;
+    delete data;
+    data = NULL;
+}
+
+bool OBSsearchIndex::isReady() const
+{
+    return data != NULL;
+}
+
+OBSsearchIndex::Data *OBSsearchIndex::createData(const QString &indexFileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+    Data *data = new Data();
+    OBSlistIndex index;
+    if (!index.open(indexFileName)) {
+        return data;
+    }
+
+    int count = index.count();
+    data->names.reserve(count);
+    data->lowerNames.reserve(count);
+    QHash<QString, int> segmentIds;
+    for (int i=0; i<count; i++) {
+        QString name = index.at(i);
+        QString lowerName = name.toLower();
+        data->names.append(name);
+        data->lowerNames.append(lowerName);
+        foreach (const QString &segment, lowerName.split(':', QString::SkipEmptyParts)) {
+            QHash<QString, int>::const_iterator it = segmentIds.constFind(segment);
+            if (it == segmentIds.constEnd()) {
+                it = segmentIds.insert(segment, data->segments.size());
+                data->segments.append(segment);
+                data->segmentMasks.append(getCharMask(segment));
+                data->segmentNames.append(QVector<int>());
+            }
+            QVector<int> &segmentNames = data->segmentNames[it.value()];
+            if (segmentNames.isEmpty() || segmentNames.last() != i) {
+                segmentNames.append(i);
+            }
+        }
+        foreach (quint64 trigram, getTrigrams(lowerName)) {
+            data->postings[trigram].append(i);
+        }
+    }
+    qDebug() << "OBSsearchIndex: indexed" << count << "names from" << indexFileName
+             << "in" << timer.elapsed() << "ms";
+    return data;
+}
+
+QVector<quint64> OBSsearchIndex::getTrigrams(const QString &lowerText)
+{
+//    Distinct trigrams, a name is only added once to a posting list
+    QVector<quint64> trigrams;
+    for (int i=0; i+2<lowerText.size(); i++) {
+        trigrams.append((quint64(lowerText.at(i).unicode()) << 32) |
+                        (quint64(lowerText.at(i+1).unicode()) << 16) |
+                        quint64(lowerText.at(i+2).unicode()));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+QStringList OBSsearchIndex::search(const QString &query, int limit) const
+{
+    QStringList results;
+    if (!data || query.isEmpty()) {
+        return results;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QString lowerQuery = query.toLower();
+    QVector<quint64> trigrams = getTrigrams(lowerQuery);
+    QVector<Match> matches;
+
+    if (trigrams.isEmpty()) {
+//        Too short for trigrams, plain substring search
+        for (int i=0; i<data->lowerNames.size(); i++) {
+            const QString &lowerName = data->lowerNames.at(i);
+            if (lowerName.contains(lowerQuery)) {
+                Match match = { getRank(lowerName, lowerQuery), 0, lowerName.size(), i };
+                matches.append(match);
+            }
+        }
+    } else {
+//        Count the query's trigrams found in each name. Names with all
+//        of them may contain the query, names with at least two thirds
+//        of them are fuzzy matches (typos, a missing character...)
+        QVector<int> hits(data->names.size(), 0);
+        QVector<int> candidates;
+        foreach (quint64 trigram, trigrams) {
+            QHash<quint64, QVector<int> >::const_iterator it = data->postings.constFind(trigram);
+            if (it == data->postings.constEnd()) {
+                continue;
+            }
+            const QVector<int> &posting = it.value();
+            for (int i=0; i<posting.size(); i++) {
+                if (hits[posting.at(i)]++ == 0) {
+                    candidates.append(posting.at(i));
+                }
+            }
+        }
+
+        int minHits = qMax(1, (trigrams.size()*2 + 2)/3);
+        foreach (int i, candidates) {
+            const QString &lowerName = data->lowerNames.at(i);
+            if (hits.at(i) == trigrams.size() && lowerName.contains(lowerQuery)) {
+                Match match = { getRank(lowerName, lowerQuery), 0, lowerName.size(), i };
+                matches.append(match);
+            } else if (hits.at(i) >= minHits) {
+                Match match = { Fuzzy, hits.at(i)*100/trigrams.size(), lowerName.size(), i };
+                matches.append(match);
+            }
+        }
+    }
+
+//    A short query with a typo (eg: "pyhton") shares few or no trigrams
+//    with the names, segments starting with about the query are looked
+//    for when nothing contains it
+    bool substringFound = false;
+    foreach (const Match &match, matches) {
+        substringFound = substringFound || match.rank <= Substring;
+    }
+    if (!substringFound && lowerQuery.size() >= 4 && !lowerQuery.contains(':')) {
+        findTypos(data->lowerNames, data->segments, data->segmentMasks, data->segmentNames,
+                  lowerQuery, matches);
+    }
+
+    int resultCount = qMin(limit, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + resultCount, matches.end(), isBetterMatch);
+    for (int i=0; i<resultCount; i++) {
+        results.append(data->names.at(matches.at(i).index));
+    }
+    qDebug() << "OBSsearchIndex: search for" << query << "found" << matches.size()
+             << "matches in" << timer.elapsed() << "ms";
+    return results;
+}
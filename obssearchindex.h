@@ -0,0 +1,86 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSSEARCHINDEX_H
+#define OBSSEARCHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
+#include <QDebug>
+#include "obslistindex.h"
+
+/*
+ * Trigram index over a listing (eg: projects), for substring and
+ * fuzzy matching anywhere in the name (eg: "python:Fac" finds
+ * devel:languages:python:Factory). It is built from the listing's
+ * OBSlistIndex on the thread pool; ready() is emitted when it can
+ * be searched.
+ *
+ * A query's trigrams are looked up in the posting lists and the
+ * hits are counted per name. Names with all the trigrams are checked
+ * for the substring, names with most of them are fuzzy matches.
+ * When no name contains the query, names with a ':' segment starting
+ * within an edit or two of it (eg: "pyhton", which shares no trigram
+ * with "python") are looked for as well.
+ * Results are ranked: exact, prefix, prefix of a ':' segment,
+ * substring, typos by edit distance, and then fuzzy by trigram overlap.
+ *
+ */
+class OBSsearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OBSsearchIndex(QObject *parent = 0);
+    ~OBSsearchIndex();
+    void build(const QString &indexFileName);
+    void clear();
+    bool isReady() const;
+    QStringList search(const QString &query, int limit = 50) const;
+
+signals:
+    void ready();
+
+private slots:
+    void buildFinished();
+
+private:
+    struct Data {
+        QStringList names;
+        QStringList lowerNames;
+        QStringList segments;
+        QVector<quint64> segmentMasks;
+        QVector<QVector<int> > segmentNames;
+        QHash<quint64, QVector<int> > postings;
+    };
+    static Data *createData(const QString &indexFileName);
+    static QVector<quint64> getTrigrams(const QString &lowerText);
+    Data *data;
+    int generation;
+    QList<QFutureWatcher<Data*>*> watchers;
+};
+
+#endif // OBSSEARCHINDEX_H
@@ -0,0 +1,165 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "obstimings.h"
+#include <cstring>
+
+// Upper limits (ms) of the histogram buckets, the last one has no limit
+const int OBStimings::bucketLimits[BucketCount - 1] =
+{ 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+
+const char *OBStimings::phaseNames[PhaseCount] =
+{ "queued", "waiting", "downloading", "parsing" };
+
+OBStimings::OBStimings()
+{
+}
+
+QString OBStimings::getEndpoint(const QUrl &url)
+{
+    QString path = url.path();
+    if (path.contains("/_status")) {
+        return "_status";
+    } else if (path.contains("/_result")) {
+        return "_result";
+    } else if (path.endsWith("/_meta")) {
+        return "_meta";
+    } else if (path.startsWith("/request")) {
+        return "request";
+    } else if (path.startsWith("/source")) {
+        return "source";
+    }
+    return "other";
+}
+
+void OBStimings::record(const QString &endpoint, const qint64 phases[PhaseCount],
+                        qint64 wireBytes, qint64 parsedBytes)
+{
+    QMutexLocker locker(&mutex);
+    if (!endpoints.contains(endpoint)) {
+        EndpointStats stats;
+        memset(&stats, 0, sizeof(stats));
+        endpoints.insert(endpoint, stats);
+    }
+
+    EndpointStats &stats = endpoints[endpoint];
+    stats.requests++;
+    stats.wireBytes += wireBytes;
+    stats.parsedBytes += parsedBytes;
+
+    for (int p=0; p<PhaseCount; p++) {
+        if (phases[p] < 0) {
+            continue;
+        }
+        int bucket = 0;
+        while (bucket < BucketCount - 1 && phases[p] > bucketLimits[bucket]) {
+            bucket++;
+        }
+        Histogram &histogram = stats.phases[p];
+        histogram.buckets[bucket]++;
+        histogram.count++;
+        histogram.total += phases[p];
+        histogram.max = qMax(histogram.max, phases[p]);
+    }
+}
+
+void OBStimings::clear()
+{
+    QMutexLocker locker(&mutex);
+    endpoints.clear();
+}
+
+QString OBStimings::toText() const
+{
+    QMutexLocker locker(&mutex);
+    QStringList lines;
+
+    QMapIterator<QString, EndpointStats> i(endpoints);
+    while (i.hasNext()) {
+        i.next();
+        const EndpointStats &stats = i.value();
+        lines << QString("%1: %2 requests, %3 bytes received, %4 bytes parsed")
+                 .arg(i.key()).arg(stats.requests).arg(stats.wireBytes).arg(stats.parsedBytes);
+
+        for (int p=0; p<PhaseCount; p++) {
+            const Histogram &histogram = stats.phases[p];
+            if (histogram.count == 0) {
+                continue;
+            }
+            QStringList buckets;
+            for (int b=0; b<BucketCount; b++) {
+                QString limit = b < BucketCount - 1 ? "<=" + QString::number(bucketLimits[b]) : ">" +
+                                                      QString::number(bucketLimits[BucketCount - 2]);
+                buckets << limit + ":" + QString::number(histogram.buckets[b]);
+            }
+            lines << QString("  %1: avg. %2 ms, max. %3 ms  [%4]")
+                     .arg(phaseNames[p], -12)
+                     .arg(histogram.total/histogram.count)
+                     .arg(histogram.max)
+                     .arg(buckets.join(" "));
+        }
+    }
+    return lines.join("\n");
+}
+
+QByteArray OBStimings::toJson() const
+{
+//    Qt 4 has no JSON support, the document is simple enough to write it by hand
+    QMutexLocker locker(&mutex);
+    QStringList limits;
+    for (int b=0; b<BucketCount - 1; b++) {
+        limits << QString::number(bucketLimits[b]);
+    }
+
+    QStringList endpointList;
+    QMapIterator<QString, EndpointStats> i(endpoints);
+    while (i.hasNext()) {
+        i.next();
+        const EndpointStats &stats = i.value();
+        QStringList phaseList;
+        for (int p=0; p<PhaseCount; p++) {
+            const Histogram &histogram = stats.phases[p];
+            QStringList buckets;
+            for (int b=0; b<BucketCount; b++) {
+                buckets << QString::number(histogram.buckets[b]);
+            }
+            phaseList << QString("        \"%1\": { \"count\": %2, \"totalMs\": %3, \"maxMs\": %4, "
+                                 "\"buckets\": [%5] }")
+                         .arg(phaseNames[p]).arg(histogram.count).arg(histogram.total)
+                         .arg(histogram.max).arg(buckets.join(", "));
+        }
+        endpointList << QString("    \"%1\": {\n"
+                                "      \"requests\": %2,\n"
+                                "      \"wireBytes\": %3,\n"
+                                "      \"parsedBytes\": %4,\n"
+                                "      \"phases\": {\n%5\n      }\n"
+                                "    }")
+                        .arg(i.key()).arg(stats.requests).arg(stats.wireBytes)
+                        .arg(stats.parsedBytes).arg(phaseList.join(",\n"));
+    }
+
+    QString json = QString("{\n"
+                           "  \"bucketLimitsMs\": [%1],\n"
+                           "  \"endpoints\": {\n%2\n  }\n"
+                           "}\n")
+            .arg(limits.join(", ")).arg(endpointList.join(",\n"));
+    return json.toUtf8();
+}
+
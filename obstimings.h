@@ -0,0 +1,71 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef OBSTIMINGS_H
+#define OBSTIMINGS_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+
+/*
+ * Timings of the finished requests, aggregated per endpoint type
+ * (_status, _result, request, source, _meta) into a histogram per
+ * phase: queued, waiting for the first byte (including connecting,
+ * which Qt4 doesn't report on its own), downloading and parsing.
+ * A phase which couldn't be measured is passed as -1.
+ * Requests are recorded on the worker thread and read from the GUI.
+ *
+ */
+class OBStimings
+{
+public:
+    enum Phase { Queued, Waiting, Downloading, Parsing, PhaseCount };
+    OBStimings();
+    static QString getEndpoint(const QUrl &url);
+    void record(const QString &endpoint, const qint64 phases[PhaseCount],
+                qint64 wireBytes, qint64 parsedBytes);
+    void clear();
+    QString toText() const;
+    QByteArray toJson() const;
+
+private:
+    enum { BucketCount = 11 };
+    static const int bucketLimits[BucketCount - 1];
+    static const char *phaseNames[PhaseCount];
+    struct Histogram {
+        int buckets[BucketCount];
+        int count;
+        qint64 total;
+        qint64 max;
+    };
+    struct EndpointStats {
+        int requests;
+        qint64 wireBytes;
+        qint64 parsedBytes;
+        Histogram phases[PhaseCount];
+    };
+    QMap<QString, EndpointStats> endpoints;
+    mutable QMutex mutex;
+};
+
+#endif // OBSTIMINGS_H
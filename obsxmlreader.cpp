@@ -20,186 +20,414 @@
 
 #include "obsxmlreader.h"
 
-OBSxmlReader* OBSxmlReader::instance = NULL;
-
 OBSxmlReader::OBSxmlReader()
 {
+    packageFound = false;
+    readingRequest = false;
+    readingResult = false;
+    takenResults = 0;
+    takenRequests = 0;
+    documentType = UnknownDocument;
+    readingText = false;
+    inHistory = false;
+    streamFile = NULL;
+    streamFileFailed = false;
+}
 
+OBSxmlReader::~OBSxmlReader()
+{
+    delete streamFile;
 }
 
-OBSxmlReader* OBSxmlReader::getInstance()
+/*
+ * There is no shared parser state: every document gets its own
+ * OBSxmlReader, and the static functions only use local readers.
+ * This allows several documents to be parsed at the same time,
+ * eg: on a QThreadPool with QtConcurrent::run(OBSxmlReader::parseData, data)
+ *
+ */
+OBSxmlReader* OBSxmlReader::parseData(const QByteArray &data)
 {
-    if (!instance) {
-        instance = new OBSxmlReader();
+    QElapsedTimer timer;
+    timer.start();
+    OBSxmlReader *xmlReader = new OBSxmlReader();
+    xmlReader->addStreamData(data);
+    xmlReader->endStream();
+    qDebug() << "OBSxmlReader: parsed" << data.size() << "bytes in"
+             << timer.elapsed() << "ms";
+    return xmlReader;
+}
+
+QString OBSxmlReader::intern(const QStringRef &string)
+{
+//    Project and user names repeat a lot across requests and results,
+//    all of them share the same copy. Readers can run on several threads.
+    static QSet<QString> strings;
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+
+    QString str = string.toString();
+    QSet<QString>::const_iterator it = strings.constFind(str);
+    if (it != strings.constEnd()) {
+        return *it;
     }
-    return instance;
+    strings.insert(str);
+    return str;
+}
+
+QString OBSxmlReader::getDataDir()
+{
+    return QDesktopServices::storageLocation(QDesktopServices::DataLocation);
 }
 
-void OBSxmlReader::addData(const QString& data)
+/*
+ * Streaming mode: the body is fed chunk by chunk as it is downloaded.
+ * Parsing stops at the end of each chunk (PrematureEndOfDocumentError)
+ * and carries on when the next one is added, so results are available
+ * before the download has finished. Directory listings and _meta files
+ * are written to <fileName>.part as they arrive, which replaces the
+ * previous file once the download is complete.
+ *
+ */
+void OBSxmlReader::addStreamData(const QByteArray &data)
 {
-    list.clear();
-    qDebug() << "OBSxmlReader addData()";
-    QXmlStreamReader xml(data);
+    if (documentType == FileDocument) {
+        writeStreamFile(data);
+        return;
+    }
 
-    while (!xml.atEnd() && !xml.hasError()) {
-        xml.readNext();
-        if (xml.name()=="status" && xml.isStartElement()) {
-            qDebug() << "OBSxmlReader: status tag found";
-            parsePackage(data);
-            obsPackage = getPackage();
-        } else if (xml.name()=="collection" && xml.isStartElement()) {
-            qDebug() << "OBSxmlReader: collection tag found";
-            parseRequests(data);
-            obsRequests = getRequests();
-        } else if (xml.name()=="directory" && xml.isStartElement()) {
-            qDebug() << "OBSxmlReader: directory tag found";
-            stringToFile(data);
-        } else if (xml.name()=="project" && xml.isStartElement()) {
-            qDebug() << "OBSxmlReader: project tag found";
-            stringToFile(data);
+//    Until the root element is known we don't know whether
+//    the data has to be written to a file
+    if (documentType == UnknownDocument) {
+        streamBuffer.append(data);
+    }
+
+    QXmlStreamReader::addData(data);
+    parse(*this);
+
+    if (documentType == FileDocument) {
+        QDir dir(getDataDir());
+        QString filePath = dir.filePath(fileName + ".part");
+        QDir fileDir(QFileInfo(filePath).absolutePath());
+        if (!fileDir.exists()) {
+            fileDir.mkpath(fileDir.absolutePath());
+        }
+        streamFile = new QFile(filePath);
+        if (!streamFile->open(QIODevice::WriteOnly)) {
+            qDebug() << "Error: Cannot write file" << fileName << "(" << streamFile->errorString() << ")";
+            streamFileFailed = true;
         }
+        writeStreamFile(streamBuffer);
+        streamBuffer.clear();
+    } else if (documentType != UnknownDocument) {
+        streamBuffer.clear();
     }
 }
 
-void OBSxmlReader::parsePackage(const QString &data)
+void OBSxmlReader::writeStreamFile(const QByteArray &data)
 {
-    QXmlStreamReader xml(data);
-    obsPackage = new OBSpackage();
+    if (streamFileFailed) {
+        return;
+    }
+    if (streamFile->write(data) != data.size()) {
+        qDebug() << "Error: Cannot write file" << fileName << "(" << streamFile->errorString() << ")";
+        streamFileFailed = true;
+    }
+}
 
-    while (!xml.atEnd() && !xml.hasError()) {
+bool OBSxmlReader::hasFileError()
+{
+    return streamFileFailed;
+}
+
+void OBSxmlReader::endStream()
+{
+    if (streamFile && streamFileFailed) {
+//        The previous file is better than an incomplete one
+        qDebug() << "Keeping the previous" << fileName;
+        discardStream();
+    } else if (streamFile) {
+        streamFile->close();
+        QString filePath = QDir(getDataDir()).filePath(fileName);
+        QFile::remove(filePath);
+        if (!streamFile->rename(filePath)) {
+            qDebug() << "Error: Cannot rename" << streamFile->fileName() << "to" << fileName;
+        }
+        delete streamFile;
+        streamFile = NULL;
+    } else if (hasError() && error() != QXmlStreamReader::PrematureEndOfDocumentError) {
+        qDebug() << "Error parsing XML!" << errorString();
+    }
+    streamBuffer.clear();
+}
+
+void OBSxmlReader::discardStream()
+{
+//    The download failed or was cancelled, the previous file is kept
+    if (streamFile) {
+        streamFile->close();
+        streamFile->remove();
+        delete streamFile;
+        streamFile = NULL;
+    }
+    streamBuffer.clear();
+}
 
+OBSxmlReader::DocumentType OBSxmlReader::getDocumentType()
+{
+    return documentType;
+}
+
+void OBSxmlReader::parse(QXmlStreamReader &xml)
+{
+    while (!xml.atEnd()) {
         xml.readNext();
+        if (xml.hasError()) {
+//            Either a broken document or the end of the data received so far
+            return;
+        }
 
-        if (xml.name()=="status") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
+        switch (documentType) {
+        case UnknownDocument:
+            parseRoot(xml);
+            break;
+        case PackageDocument:
+            parsePackage(xml);
+            break;
+        case ResultListDocument:
+            parseResultList(xml);
+            break;
+        case RequestsDocument:
+            parseRequests(xml);
+            break;
+        case FileDocument:
+        case OtherDocument:
+//            Saved as it is or ignored, there is nothing to parse
+            return;
+        }
+    }
+}
 
-                if (attrib.value("code").toString() == "unregistered_ichain_user") {
-                    qDebug() << "Unregistered username!";
-                }
-                else {
-                    obsPackage->setName(attrib.value("package").toString());
-                    obsPackage->setStatus(attrib.value("code").toString());
-                    qDebug() << "Package:" << obsPackage->getName() << "Status:" << obsPackage->getStatus();
-                }
-            }
-        } // end status
+void OBSxmlReader::parseRoot(QXmlStreamReader &xml)
+{
+//    The root element tells us which kind of document we have got.
+//    Every following token goes straight to the right parser,
+//    so that the document is read only once.
+    if (!xml.isStartElement()) {
+        return;
+    }
 
-        if (xml.name()=="details") {
-            if (xml.tokenType() != QXmlStreamReader::StartElement) {
-                return;
+    if (xml.name()=="resultlist") {
+        qDebug() << "OBSxmlReader: resultlist tag found";
+        documentType = ResultListDocument;
+        parseResultList(xml);
+    } else if (xml.name()=="status") {
+        qDebug() << "OBSxmlReader: status tag found";
+        documentType = PackageDocument;
+        parsePackage(xml);
+    } else if (xml.name()=="collection") {
+        qDebug() << "OBSxmlReader: collection tag found";
+        documentType = RequestsDocument;
+        parseRequests(xml);
+    } else if (xml.name()=="directory" || xml.name()=="project") {
+        qDebug() << "OBSxmlReader:" << xml.name() << "tag found";
+//        Listings and metadata are only saved when they've been asked for
+        documentType = fileName.isEmpty() ? OtherDocument : FileDocument;
+    } else {
+        qDebug() << "OBSxmlReader: unknown root tag" << xml.name();
+        documentType = OtherDocument;
+    }
+}
+
+bool OBSxmlReader::parseText(QXmlStreamReader &xml, const QString &tagName)
+{
+//    Text can be split across several chunks, so it is collected
+//    until the end element shows up
+    if (xml.name()==tagName && xml.isStartElement()) {
+        readingText = true;
+        elementText.clear();
+    } else if (readingText && xml.isCharacters()) {
+        elementText.append(xml.text());
+    } else if (readingText && xml.name()==tagName && xml.isEndElement()) {
+        readingText = false;
+        return true;
+    }
+    return false;
+}
+
+void OBSxmlReader::parsePackage(QXmlStreamReader &xml)
+{
+    if (xml.name()=="status") {
+        if (xml.isStartElement()) {
+            packageFound = true;
+            QXmlStreamAttributes attrib = xml.attributes();
+
+            if (attrib.value("code").toString() == "unregistered_ichain_user") {
+                qDebug() << "Unregistered username!";
+            }
+            else {
+                obsPackage.setName(attrib.value("package").toString());
+                obsPackage.setStatus(attrib.value("code").toString());
+                qDebug() << "Package:" << obsPackage.getName() << "Status:" << obsPackage.getStatus();
             }
-            xml.readNext();
-            obsPackage->setDetails(xml.text().toString());
-//               qDebug() << "details:" << details;
-        }  else {
-//            no details
-        } // end details
+        }
+    } // end status
 
-    } // end while
+    if (parseText(xml, "details") && packageFound) {
+        obsPackage.setDetails(elementText);
+//        qDebug() << "details:" << details;
+    } // end details
+}
 
-    if (xml.hasError()) {
-        qDebug() << "Error parsing XML!" << xml.errorString();
-    }
+bool OBSxmlReader::hasPackage()
+{
+    return packageFound;
 }
 
-OBSpackage* OBSxmlReader::getPackage()
+OBSpackage OBSxmlReader::getPackage()
 {
     return obsPackage;
 }
 
-void OBSxmlReader::parseRequests(const QString &data)
+void OBSxmlReader::parseResultList(QXmlStreamReader &xml)
 {
-    QXmlStreamReader xml(data);
-    obsRequests.clear();
+    if (xml.name()=="resultlist") {
+        if (xml.isStartElement()) {
+            resultListState = xml.attributes().value("state").toString();
+        }
+    } // end resultlist
+
+    if (xml.name()=="result") {
+        if (xml.isStartElement()) {
+            QXmlStreamAttributes attrib = xml.attributes();
+            resultProject = intern(attrib.value("project"));
+            resultRepository = intern(attrib.value("repository"));
+            resultArch = intern(attrib.value("arch"));
+        }
+    } // end result
+
+    if (xml.name()=="status") {
+        if (xml.isStartElement()) {
+            QXmlStreamAttributes attrib = xml.attributes();
+            readingResult = true;
+            resultPackage = OBSpackage();
+            resultPackage.setProject(resultProject);
+            resultPackage.setRepository(resultRepository);
+            resultPackage.setArch(resultArch);
+            resultPackage.setName(intern(attrib.value("package")));
+            resultPackage.setStatus(attrib.value("code").toString());
+        } else if (xml.isEndElement() && readingResult) {
+            resultList.append(resultPackage);
+            readingResult = false;
+        }
+    } // end status
 
-    while (!xml.atEnd() && !xml.hasError()) {
-        xml.readNext();
+    if (parseText(xml, "details") && readingResult) {
+        resultPackage.setDetails(elementText);
+    } // end details
+}
 
-        if (xml.name()=="collection") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                QStringRef matches = attrib.value("matches");
-                QStringRef code = attrib.value("code");
-                requestNumber = matches.toString();
+QVector<OBSpackage> OBSxmlReader::getResultList()
+{
+    return resultList;
+}
 
-                qDebug() << "Matches:" << requestNumber;
+QVector<OBSpackage> OBSxmlReader::takeNewResults()
+{
+    QVector<OBSpackage> newResults = resultList.mid(takenResults);
+    takenResults = resultList.size();
+    return newResults;
+}
 
-                if (code.toString() == "unregistered_ichain_user") {
-                    qDebug() << "Unregistered username!";
-                } else {
-//                    data = code.toString();
-                }
-            }
-        } // collection
+QString OBSxmlReader::getResultListState()
+{
+    return resultListState;
+}
 
-        if (xml.name()=="request") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                obsRequest = new OBSrequest;
-                obsRequest->setId(attrib.value("id").toString());
+void OBSxmlReader::parseRequests(QXmlStreamReader &xml)
+{
+    if (xml.name()=="collection") {
+        if (xml.isStartElement()) {
+            QXmlStreamAttributes attrib = xml.attributes();
+            QStringRef matches = attrib.value("matches");
+            QStringRef code = attrib.value("code");
+            requestNumber = matches.toString();
+
+            qDebug() << "Matches:" << requestNumber;
+
+            if (code.toString() == "unregistered_ichain_user") {
+                qDebug() << "Unregistered username!";
+            } else {
+//                data = code.toString();
             }
         }
+    } // collection
+
+    if (xml.name()=="request") {
+        if (xml.isStartElement()) {
+            QXmlStreamAttributes attrib = xml.attributes();
+            readingRequest = true;
+            obsRequest = OBSrequest();
+            obsRequest.setId(attrib.value("id").toString());
+        } else if (xml.isEndElement() && readingRequest) {
+//            Requests without a description are kept too
+            obsRequests.append(obsRequest);
+            readingRequest = false;
+        }
+    }
+
+//    History entries have their own descriptions
+    if (xml.name()=="history") {
+        inHistory = xml.isStartElement();
+    }
+
+    if (!readingRequest || inHistory) {
+        return;
+    }
+
+    if (xml.isStartElement()) {
 
         if (xml.name()=="action")  {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                obsRequest->setActionType(attrib.value("type").toString());
-                qDebug() << "Action type:" <<  obsRequest->getActionType();
-//                if (obsRequest->getActionType()=="delete") {
-//                    obsRequest->setSourceProject("N/A");
-//                }
-            }
+            QXmlStreamAttributes attrib = xml.attributes();
+            obsRequest.setActionType(attrib.value("type").toString());
+            qDebug() << "Action type:" <<  obsRequest.getActionType();
+//            if (obsRequest->getActionType()=="delete") {
+//                obsRequest->setSourceProject("N/A");
+//            }
         } // action
 
         if (xml.name()=="source") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                obsRequest->setSourceProject(attrib.value("project").toString());
-                obsRequest->setSourcePackage(attrib.value("package").toString());
-                qDebug() << "Source: " <<  obsRequest->getSource();
-            }
+            QXmlStreamAttributes attrib = xml.attributes();
+            obsRequest.setSourceProject(intern(attrib.value("project")));
+            obsRequest.setSourcePackage(attrib.value("package").toString());
+            qDebug() << "Source: " <<  obsRequest.getSource();
         } // source
 
         if (xml.name()=="target") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                obsRequest->setTargetProject(attrib.value("project").toString());
-                obsRequest->setTargetPackage(attrib.value("package").toString());
-                qDebug() << "Target: " <<  obsRequest->getTarget();
-            }
+            QXmlStreamAttributes attrib = xml.attributes();
+            obsRequest.setTargetProject(intern(attrib.value("project")));
+            obsRequest.setTargetPackage(attrib.value("package").toString());
+            qDebug() << "Target: " <<  obsRequest.getTarget();
         } // target
 
         if (xml.name()=="state") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-                obsRequest->setState(attrib.value("name").toString());
-                qDebug() << "State: " <<  obsRequest->getState();
-                obsRequest->setRequester(attrib.value("who").toString());
-                qDebug() << "Requester: " <<  obsRequest->getRequester();
-                obsRequest->setDate(attrib.value("when").toString());
-                qDebug() << "Date: " <<  obsRequest->getDate();
-            }
+            QXmlStreamAttributes attrib = xml.attributes();
+            obsRequest.setState(attrib.value("name").toString());
+            qDebug() << "State: " <<  obsRequest.getState();
+            obsRequest.setRequester(intern(attrib.value("who")));
+            qDebug() << "Requester: " <<  obsRequest.getRequester();
+            obsRequest.setDate(attrib.value("when").toString());
+            qDebug() << "Date: " <<  obsRequest.getDate();
         } // state
-
-        if (xml.name()=="description") {
-            if (xml.tokenType() != QXmlStreamReader::StartElement) {
-                return;
-            }
-            xml.readNext();
-            obsRequest->setDescription(xml.text().toString());
-            qDebug() << "Description:\n" <<  obsRequest->getDescription();
-            xml.readNextStartElement();
-            obsRequests.append(obsRequest);
-        } // description
     }
 
-    if (xml.hasError()) {
-        qDebug() << "Error parsing XML!" << xml.errorString();
-    }
+    if (parseText(xml, "description")) {
+        obsRequest.setDescription(elementText);
+        qDebug() << "Description:\n" <<  obsRequest.getDescription();
+    } // description
 }
 
-void OBSxmlReader::parseList(QXmlStreamReader &xml)
+void OBSxmlReader::parseList(QXmlStreamReader &xml, QStringList &list)
 {
     qDebug() << "OBSxmlReader parseList()";
     while (!xml.atEnd() && !xml.hasError()) {
@@ -239,97 +467,90 @@ void OBSxmlReader::parseList(QXmlStreamReader &xml)
     }
 }
 
-void OBSxmlReader::stringToFile(const QString &data)
+bool OBSxmlReader::openFile(QFile &file)
 {
-    QString dataDir = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
-    QDir dir(dataDir);
-
-    if (!dir.exists()) {
-        dir.mkpath(dataDir);
+    qDebug() << "OBSxmlReader openFile()" << file.fileName();
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Error: Cannot read file " << file.fileName() << "(" << file.errorString() << ")";
+        return false;
     }
-
-    QFile file(fileName);
-    QDir::setCurrent(dataDir);
-
-    file.open(QIODevice::WriteOnly);
-    QTextStream stream(&file);
-    stream << data;
-    file.close();
+    return true;
 }
 
-QFile* OBSxmlReader::openFile()
+QStringList OBSxmlReader::readList(const QString &fileName)
 {
-    qDebug() << "OBSxmlReader openFile()";
-    list.clear();
-    QFile* file = new QFile(fileName);
-    QString dataDir = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
-    QDir::setCurrent(dataDir);
-    if (!file->open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Error: Cannot read file " << dataDir << fileName << "(" << file->errorString() << ")";
+    QStringList list;
+    QFile file(QDir(getDataDir()).filePath(fileName));
+
+    if (openFile(file)) {
+        QXmlStreamReader xml(&file);
+        parseList(xml, list);
     }
-    return file;
+    return list;
 }
 
-void OBSxmlReader::readFile()
+OBSprojectMeta OBSxmlReader::readProjectMeta(const QString &fileName)
 {
-    QXmlStreamReader xml;
-    xml.setDevice(openFile());
-    parseList(xml);
-}
+//    The whole _meta is read in one pass, see OBSmetaCache
+    OBSprojectMeta projectMeta;
+    QFile file(QDir(getDataDir()).filePath(fileName));
+    if (!openFile(file)) {
+        return projectMeta;
+    }
 
-void OBSxmlReader::getArchsForRepository(const QString &repository)
-{
-    qDebug() << "OBSxmlReader getArchsForRepository()";
-    list.clear();
-    QXmlStreamReader xml;
-    xml.setDevice(openFile());
-    bool repositoryFound = false;
+    QXmlStreamReader xml(&file);
+    OBSprojectMeta::Repository repository;
+    bool inRepository = false;
 
     while (!xml.atEnd() && !xml.hasError()) {
 
         xml.readNext();
 
-        if (xml.name()=="repository") {
-            if (xml.isStartElement()) {
-                QXmlStreamAttributes attrib = xml.attributes();
-
-                if (attrib.value("name")==repository) {
-//                    qDebug() << "Repository: " << attrib.value("name").toString();
-                    repositoryFound = true;
-                } else {
-                    repositoryFound = false;
-                }
+        if (xml.isStartElement()) {
+            QXmlStreamAttributes attrib = xml.attributes();
+
+            if (xml.name()=="project" && !inRepository) {
+                projectMeta.setProject(attrib.value("name").toString());
+            } else if (xml.name()=="repository") {
+                repository = OBSprojectMeta::Repository();
+                repository.name = attrib.value("name").toString();
+                inRepository = true;
+            } else if (xml.name()=="path" && inRepository) {
+                OBSprojectMeta::Path path;
+                path.project = attrib.value("project").toString();
+                path.repository = attrib.value("repository").toString();
+                repository.paths.append(path);
+            } else if (xml.name()=="arch" && inRepository) {
+                repository.archs.append(xml.readElementText());
             }
-        } // end repository
-
-        if (xml.name()=="arch" && repositoryFound) {
-            xml.readNext();
-//            qDebug() << "Arch:" << xml.text().toString();
-            list.append(xml.text().toString());
-            xml.readNextStartElement();
-
-        } // end arch
+        } else if (xml.isEndElement() && xml.name()=="repository") {
+            projectMeta.addRepository(repository);
+            inRepository = false;
+        }
 
     } // end while
 
     if (xml.hasError()) {
         qDebug() << "Error parsing XML!" << xml.errorString();
     }
+    return projectMeta;
 }
 
-QList<OBSrequest*> OBSxmlReader::getRequests()
+QVector<OBSrequest> OBSxmlReader::getRequests()
 {
     return obsRequests;
 }
 
-int OBSxmlReader::getRequestNumber()
+QVector<OBSrequest> OBSxmlReader::takeNewRequests()
 {
-    return requestNumber.toInt();
+    QVector<OBSrequest> newRequests = obsRequests.mid(takenRequests);
+    takenRequests = obsRequests.size();
+    return newRequests;
 }
 
-QStringList OBSxmlReader::getList()
+int OBSxmlReader::getRequestNumber()
 {
-    return list;
+    return requestNumber.toInt();
 }
 
 void OBSxmlReader::setFileName(const QString &fileName)
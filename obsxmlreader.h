@@ -26,38 +26,77 @@
 #include <QStringList>
 #include <QFile>
 #include <QDir>
+#include <QFileInfo>
 #include <QDesktopServices>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QSet>
+#include <QMutex>
 #include "obspackage.h"
 #include "obsrequest.h"
+#include "obsprojectmeta.h"
 
 class OBSxmlReader : public QXmlStreamReader
 {
 public:
-    static OBSxmlReader* getInstance();
-    void addData(const QString &data);
+    OBSxmlReader();
+    ~OBSxmlReader();
+    static OBSxmlReader* parseData(const QByteArray &data);
+    static QStringList readList(const QString &fileName);
+    static OBSprojectMeta readProjectMeta(const QString &fileName);
+    static QString getDataDir();
+    void addStreamData(const QByteArray &data);
+    void endStream();
+    void discardStream();
+    bool hasFileError();
 
-    OBSpackage* getPackage();
-    QList<OBSrequest*> getRequests();
+    enum DocumentType { UnknownDocument, PackageDocument, ResultListDocument,
+                        RequestsDocument, FileDocument, OtherDocument };
+    DocumentType getDocumentType();
+    bool hasPackage();
+    OBSpackage getPackage();
+    QVector<OBSpackage> getResultList();
+    QVector<OBSpackage> takeNewResults();
+    QString getResultListState();
+    QVector<OBSrequest> getRequests();
+    QVector<OBSrequest> takeNewRequests();
     int getRequestNumber();
-    QStringList getList();
-    void readFile();
     void setFileName(const QString &fileName);
-    void getArchsForRepository(const QString &repository);
 
 private:
-    static OBSxmlReader* instance;
-    OBSxmlReader();
-    void parsePackage(const QString &data);
-    void parseRequests(const QString &data);
-    void parseList(QXmlStreamReader &xml);
-    OBSpackage *obsPackage;
-    QList<OBSrequest*> obsRequests;
-    OBSrequest *obsRequest;
+    static QString intern(const QStringRef &string);
+    static bool openFile(QFile &file);
+    static void parseList(QXmlStreamReader &xml, QStringList &list);
+    void parse(QXmlStreamReader &xml);
+    void parseRoot(QXmlStreamReader &xml);
+    bool parseText(QXmlStreamReader &xml, const QString &tagName);
+    void parsePackage(QXmlStreamReader &xml);
+    void parseRequests(QXmlStreamReader &xml);
+    void parseResultList(QXmlStreamReader &xml);
+    DocumentType documentType;
+    QString elementText;
+    bool readingText;
+    OBSpackage obsPackage;
+    bool packageFound;
+    QVector<OBSpackage> resultList;
+    int takenResults;
+    OBSpackage resultPackage;
+    bool readingResult;
+    QString resultProject;
+    QString resultRepository;
+    QString resultArch;
+    QString resultListState;
+    QVector<OBSrequest> obsRequests;
+    int takenRequests;
+    OBSrequest obsRequest;
+    bool readingRequest;
+    bool inHistory;
     QString requestNumber;
-    QStringList list;
-    void stringToFile(const QString &data);
     QString fileName;
-    QFile* openFile();
+    QByteArray streamBuffer;
+    QFile *streamFile;
+    bool streamFileFailed;
+    void writeStreamFile(const QByteArray &data);
 };
 
 #endif // OBSXMLREADER_H
@@ -0,0 +1,202 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "pollscheduler.h"
+
+static const int minute = 60000;
+static const int hour = 60*minute;
+
+static int randomUpTo(int max)
+{
+//    RAND_MAX can be as low as 32767, so qrand() % max would
+//    only spread over the first half minute of an interval
+    return int(qint64(max) * qrand() / RAND_MAX);
+}
+
+PollScheduler::PollScheduler(QObject *parent) :
+    QObject(parent)
+{
+    active = false;
+    defaultInterval = 15*minute;
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    connect(timer, SIGNAL(timeout()), this, SLOT(pollDueKeys()));
+    qsrand(QDateTime::currentDateTime().toTime_t());
+}
+
+void PollScheduler::setDefaultInterval(int msecs)
+{
+    msecs = qMax(minute, msecs);
+    if (msecs == defaultInterval) {
+        return;
+    }
+    defaultInterval = msecs;
+
+//    Keys polled at the default interval (eg: the requests) would
+//    otherwise wait for the old one before picking up the new one
+    QMutableHashIterator<QString, Entry> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().interval == 0) {
+            schedule(i.value(), 0);
+        }
+    }
+    armTimer();
+}
+
+int PollScheduler::getDefaultInterval()
+{
+    return defaultInterval;
+}
+
+void PollScheduler::setKeys(const QStringList &keys)
+{
+    foreach (const QString &key, entries.keys()) {
+        if (!keys.contains(key)) {
+            entries.remove(key);
+        }
+    }
+
+//    New keys are spread across the default interval, they
+//    usually have just been fetched by a manual refresh
+    foreach (const QString &key, keys) {
+        if (!entries.contains(key)) {
+            Entry entry;
+            entry.failures = 0;
+            entry.interval = 0;
+            entry.nextPoll = QDateTime::currentDateTime().addMSecs(randomUpTo(defaultInterval));
+            entries.insert(key, entry);
+        }
+    }
+    armTimer();
+}
+
+void PollScheduler::reportStatus(const QString &key, OBSpackage::Status status)
+{
+    if (!entries.contains(key)) {
+        return;
+    }
+
+    Entry &entry = entries[key];
+    if (status==OBSpackage::Failed || status==OBSpackage::Unresolvable ||
+            status==OBSpackage::Broken) {
+        entry.failures++;
+    } else {
+        entry.failures = 0;
+    }
+    schedule(entry, intervalForStatus(status, entry.failures));
+    qDebug() << "Next poll for" << key << "at" << entry.nextPoll.toString();
+    armTimer();
+}
+
+int PollScheduler::intervalForStatus(OBSpackage::Status status, int failures)
+{
+    switch (status) {
+    case OBSpackage::Blocked:
+    case OBSpackage::Dispatching:
+    case OBSpackage::Scheduled:
+    case OBSpackage::Building:
+    case OBSpackage::Signing:
+    case OBSpackage::Finished:
+        return minute;
+    case OBSpackage::Succeeded:
+        return hour;
+    case OBSpackage::Failed:
+    case OBSpackage::Unresolvable:
+    case OBSpackage::Broken:
+//        5, 10, 20, 40 and then 60 minutes
+        return qMin(hour, (5*minute) << qMin(failures-1, 4));
+    default:
+//        Follows the default interval, even when it changes
+        return 0;
+    }
+}
+
+int PollScheduler::jitter(int interval)
+{
+//    +/- 10%
+    int range = interval/5;
+    return interval - range/2 + randomUpTo(range);
+}
+
+void PollScheduler::schedule(Entry &entry, int interval)
+{
+    entry.interval = interval;
+    if (interval == 0) {
+        interval = defaultInterval;
+    }
+    entry.nextPoll = QDateTime::currentDateTime().addMSecs(jitter(interval));
+}
+
+void PollScheduler::start()
+{
+    active = true;
+    armTimer();
+}
+
+void PollScheduler::stop()
+{
+    active = false;
+    timer->stop();
+}
+
+bool PollScheduler::isActive()
+{
+    return active;
+}
+
+void PollScheduler::armTimer()
+{
+    if (!active || entries.isEmpty()) {
+        timer->stop();
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    qint64 wait = hour;
+    foreach (const Entry &entry, entries) {
+        wait = qMin(wait, now.msecsTo(entry.nextPoll));
+    }
+    timer->start(qMax(qint64(0), wait));
+}
+
+void PollScheduler::pollDueKeys()
+{
+//    Keys which are due in the next few seconds are polled as well,
+//    so that rows of the same project can share a request
+    QDateTime limit = QDateTime::currentDateTime().addMSecs(5000);
+    QStringList dueKeys;
+
+    QMutableHashIterator<QString, Entry> i(entries);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().nextPoll <= limit) {
+            dueKeys.append(i.key());
+//            Polled again after the same interval if no status is reported
+            schedule(i.value(), i.value().interval);
+        }
+    }
+
+    if (!dueKeys.isEmpty()) {
+        qDebug() << "Polling" << dueKeys.size() << "keys";
+        emit pollDue(dueKeys);
+    }
+    armTimer();
+}
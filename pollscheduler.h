@@ -0,0 +1,77 @@
+/*
+ *  Qactus - A Qt based OBS notifier
+ *
+ *  Copyright (C) 2015 Javier Llorente <javier@opensuse.org>
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) version 3.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QDateTime>
+#include <QStringList>
+#include <QDebug>
+#include "obspackage.h"
+
+/*
+ * Each polled key (a project/package/repository/arch row, or the
+ * requests) has its own next-poll time, which depends on the last
+ * status seen for it: rows which are building are polled every minute,
+ * succeeded ones hourly and failed ones with an increasing backoff.
+ * Everything else is polled at the interval set in Configure.
+ * Intervals are jittered so that the polls don't come in bursts.
+ *
+ */
+class PollScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PollScheduler(QObject *parent = 0);
+    void setDefaultInterval(int msecs);
+    int getDefaultInterval();
+    void setKeys(const QStringList &keys);
+    void reportStatus(const QString &key, OBSpackage::Status status);
+    void start();
+    void stop();
+    bool isActive();
+
+signals:
+    void pollDue(const QStringList &keys);
+
+private slots:
+    void pollDueKeys();
+
+private:
+    struct Entry {
+        QDateTime nextPoll;
+        int interval; // 0 is the default interval
+        int failures;
+    };
+    QHash<QString, Entry> entries;
+    QTimer *timer;
+    bool active;
+    int defaultInterval;
+    int intervalForStatus(OBSpackage::Status status, int failures);
+    int jitter(int interval);
+    void schedule(Entry &entry, int interval);
+    void armTimer();
+};
+
+#endif // POLLSCHEDULER_H
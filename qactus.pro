@@ -3,6 +3,7 @@
 # -------------------------------------------------
 unix:isEmpty(PREFIX):PREFIX = /usr/local
 QT += network
+LIBS += -lz
 TARGET = qactus
 TEMPLATE = app
 DEPENDPATH += .
@@ -17,6 +18,18 @@ SOURCES += main.cpp \
     obsaccess.cpp \
     obsxmlreader.cpp \
     obsrequest.cpp \
+    obscache.cpp \
+    obscachemanifest.cpp \
+    obsprojectmeta.cpp \
+    obsmetacache.cpp \
+    obscookiejar.cpp \
+    obsinflater.cpp \
+    pollscheduler.cpp \
+    obstimings.cpp \
+    debugpanel.cpp \
+    obslistindex.cpp \
+    obslistmodel.cpp \
+    obssearchindex.cpp \
     roweditor.cpp
 HEADERS += mainwindow.h \
     trayicon.h \
@@ -26,11 +39,24 @@ HEADERS += mainwindow.h \
     obsaccess.h \
     obsxmlreader.h \
     obsrequest.h \
+    obscache.h \
+    obscachemanifest.h \
+    obsprojectmeta.h \
+    obsmetacache.h \
+    obscookiejar.h \
+    obsinflater.h \
+    pollscheduler.h \
+    obstimings.h \
+    debugpanel.h \
+    obslistindex.h \
+    obslistmodel.h \
+    obssearchindex.h \
     roweditor.h
 FORMS += mainwindow.ui \
     configure.ui \
     login.ui \
-    roweditor.ui
+    roweditor.ui \
+    debugpanel.ui
 OTHER_FILES += README.md \
     LICENSE \
     license_template.txt
@@ -27,8 +27,15 @@ RowEditor::RowEditor(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    xmlReader = OBSxmlReader::getInstance();
-    initProjectAutocompleter();
+    foreach (OBSaccess *obsAccess, OBSaccess::getInstances()) {
+        ui->comboBoxServer->addItem(obsAccess->getApiUrl());
+    }
+    if (ui->comboBoxServer->count() == 0) {
+        ui->comboBoxServer->addItem(OBSaccess::getDefaultApiUrl());
+    }
+
+    initAutocompleters();
+    connect(ui->comboBoxServer, SIGNAL(currentIndexChanged(int)), this, SLOT(serverChanged()));
 }
 
 RowEditor::~RowEditor()
@@ -36,21 +43,77 @@ RowEditor::~RowEditor()
     delete ui;
 }
 
-QString RowEditor::getLastUpdateDate()
+OBSaccess *RowEditor::getObsAccess()
+{
+    return OBSaccess::getInstance(getApiUrl());
+}
+
+QString RowEditor::getApiUrl()
+{
+    return ui->comboBoxServer->currentText();
+}
+
+void RowEditor::setApiUrl(const QString &apiUrl)
+{
+    int index = ui->comboBoxServer->findText(apiUrl);
+    if (index == -1) {
+        ui->comboBoxServer->addItem(apiUrl);
+        index = ui->comboBoxServer->count() - 1;
+    }
+    ui->comboBoxServer->setCurrentIndex(index);
+}
+
+void RowEditor::serverChanged()
+{
+//    The lists of the other server don't apply
+    revalidations.clear();
+    projectModel->setIndex(getIndexFor("projects"));
+    projectCompleter->setModel(projectModel);
+    projectSearch->build(getIndexFileName("projects"));
+    packageModel->setIndex(NULL);
+    packageCompleter->setModel(packageModel);
+    packageSearch->clear();
+    repositoryModel->setIndex(NULL);
+    archModel->setIndex(NULL);
+}
+
+void RowEditor::projectSearchReady()
+{
+    searchProjects(ui->lineEditProject->text());
+}
+
+void RowEditor::searchProjects(const QString &text)
+{
+    updateCompleter(projectCompleter, projectModel, projectSearch, projectResults, text);
+}
+
+void RowEditor::packageSearchReady()
+{
+    searchPackages(ui->lineEditPackage->text());
+}
+
+void RowEditor::searchPackages(const QString &text)
 {
-    QSettings settings("Qactus","Qactus");
-    settings.beginGroup("LastUpdate");
-    QString lastUpdateItem = settings.value("ProjectList").toString();
-    settings.endGroup();
-    return lastUpdateItem;
+    updateCompleter(packageCompleter, packageModel, packageSearch, packageResults, text);
 }
 
-void RowEditor::setLastUpdateDate(const QString &date)
+void RowEditor::updateCompleter(QCompleter *completer, OBSlistModel *model, OBSsearchIndex *search,
+                                QStringListModel *results, const QString &text)
 {
-    QSettings settings("Qactus","Qactus");
-    settings.beginGroup("LastUpdate");
-    settings.setValue("ProjectList", date);
-    settings.endGroup();
+//    Names starting with the text come from the sorted index, the
+//    ranked search is only used when there are none of them
+//    (a substring or a typo), as it is slower and resets its model
+    model->setPrefix(text);
+    if (text.isEmpty() || model->rowCount() > 0 || !search->isReady()) {
+        if (completer->model() != model) {
+            completer->setModel(model);
+        }
+    } else {
+        results->setStringList(search->search(text));
+        if (completer->model() != results) {
+            completer->setModel(results);
+        }
+    }
 }
 
 QString RowEditor::getProject()
@@ -95,128 +158,209 @@ void RowEditor::setArch(const QString &arch)
 
 QStringList RowEditor::getListFor(const QString &name)
 {
-    QStringList stringList;
-    QString lastUpdateStr = getLastUpdateDate();
-    QDate lastUpdateDate = QDate::fromString(lastUpdateStr);
-    QString dataDir = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
-    QDir::setCurrent(dataDir);
-    QString fileName = name + ".xml";
-    xmlReader->setFileName(fileName);
-
-    /* The XML file is downloaded if
-     * it doesn't exist or
-     * there is no lastupdate entry in settings file or
-     * 7 days have passed since the XML file was downloaded
-     */
-    if (!QFile::exists(fileName) ||
-            lastUpdateStr.isEmpty() ||
-            lastUpdateDate.daysTo(QDate::currentDate()) == -7) {
-        OBSaccess *obsAccess = OBSaccess::getInstance();
+//    A cached list is used right away, even if it is stale, and
+//    revalidated in the background. Only a missing list is waited for.
+    OBSaccess *obsAccess = getObsAccess();
+    QString fileName = obsAccess->getDataFileName(name + ".xml");
+
+    if (!QFile::exists(QDir(OBSxmlReader::getDataDir()).filePath(fileName))) {
         if (obsAccess->isAuthenticated()) {
-            qDebug() << "Downloading" << name + "...";
-            QProgressDialog progress(tr("Downloading") + name + "...", 0, 0, 0, this);
-            progress.setWindowModality(Qt::WindowModal);
-            progress.show();
-
-            if (name == "projects") {
-                stringList = obsAccess->getProjectList();
-            } else if (name.contains("meta")) {
-                QStringList projectName = name.split("_meta");
-                stringList = obsAccess->getMetadataForProject(projectName[0]);
-            } else {
-                stringList = obsAccess->getPackageListForProject(name);
-            }
-            setLastUpdateDate(QDate::currentDate().toString());
+            return downloadList(name);
         }
+    } else {
+        revalidate(name);
     }
     qDebug() << "Reading" << name;
-    xmlReader->readFile();
-    stringList = xmlReader->getList();
+    return OBSxmlReader::readList(fileName);
+}
 
+QStringList RowEditor::downloadList(const QString &name)
+{
+    QStringList stringList;
+    OBSaccess *obsAccess = getObsAccess();
+    qDebug() << "Downloading" << name + "...";
+    QProgressDialog progress(tr("Downloading") + name + "...", tr("Cancel"), 0, 0, this);
+    progress.setWindowModality(Qt::WindowModal);
+    connect(&progress, SIGNAL(canceled()), obsAccess, SLOT(cancelListRequests()));
+    progress.show();
+
+    if (name == "projects") {
+        stringList = obsAccess->getProjectList();
+    } else if (name.endsWith("_meta")) {
+        QStringList projectName = name.split("_meta");
+        stringList = obsAccess->getMetadataForProject(projectName[0]);
+    } else {
+        stringList = obsAccess->getPackageListForProject(name);
+    }
     return stringList;
 }
 
-void RowEditor::initProjectAutocompleter()
+OBSprojectMeta RowEditor::getMetaFor(const QString &project)
 {
-    projectList = getListFor("projects");
-    QStringListModel *model = new QStringListModel(projectList);
-    projectCompleter = new QCompleter(model, this);
+//    Repositories and arches are looked up in the parsed _meta
+    OBSaccess *obsAccess = getObsAccess();
+    QString name = project + "_meta";
+    if (!QFile::exists(QDir(OBSxmlReader::getDataDir()).filePath(obsAccess->getDataFileName(name + ".xml")))) {
+        if (obsAccess->isAuthenticated()) {
+            downloadList(name);
+        }
+    } else {
+        revalidate(name);
+    }
+    return obsAccess->getProjectMeta(project);
+}
 
-    ui->lineEditProject->setCompleter(projectCompleter);
+void RowEditor::revalidate(const QString &name)
+{
+    OBSaccess *obsAccess = getObsAccess();
+    if (!obsAccess->isAuthenticated() || revalidations.values().contains(name) ||
+            !obsAccess->isListStale(obsAccess->getDataFileName(name + ".xml"))) {
+        return;
+    }
 
-    connect(ui->lineEditProject, SIGNAL(textEdited(const QString&)),
-            this, SLOT(refreshProjectAutocompleter(const QString&)));
-    connect(projectCompleter, SIGNAL(activated(const QString&)),
-            this, SLOT(autocompletedProjectName_clicked(const QString&)));
+    qDebug() << "Revalidating" << name;
+    int requestId;
+    if (name == "projects") {
+        requestId = obsAccess->revalidateProjectList();
+    } else if (name.endsWith("_meta")) {
+        requestId = obsAccess->revalidateMetadata(name.left(name.size() - QString("_meta").size()));
+    } else {
+        requestId = obsAccess->revalidatePackageList(name);
+    }
+    revalidations.insert(requestId, name);
+    connect(obsAccess, SIGNAL(requestFinished(int)),
+            this, SLOT(revalidationFinished(int)), Qt::UniqueConnection);
 }
 
-void RowEditor::refreshProjectAutocompleter(const QString&)
+void RowEditor::revalidationFinished(int requestId)
 {
-    QStringListModel *model = (QStringListModel*)(projectCompleter->model());
-    model->setStringList(projectList);
+    if (sender() != getObsAccess() || !revalidations.contains(requestId)) {
+        return;
+    }
+
+//    Nothing to do if the server answered 304 Not Modified (the index
+//    is still newer than the list). The _meta has no index, the arches
+//    are looked up again when a repository is picked.
+    QString name = revalidations.take(requestId);
+    if (isIndexUpToDate(name)) {
+        return;
+    }
+    if (name == "projects") {
+        projectModel->setIndex(getIndexFor(name));
+        projectSearch->build(getIndexFileName(name));
+    } else if (name == ui->lineEditProject->text()) {
+        packageModel->setIndex(getIndexFor(name));
+        packageModel->setPrefix(ui->lineEditPackage->text());
+        packageSearch->build(getIndexFileName(name));
+    } else if (name == ui->lineEditProject->text() + "_meta") {
+        repositoryModel->setList(getMetaFor(ui->lineEditProject->text()).getRepositories());
+        repositoryModel->setPrefix(ui->lineEditRepository->text());
+    }
 }
 
-void RowEditor::autocompletedProjectName_clicked(const QString &projectName)
+QString RowEditor::getIndexFileName(const QString &name)
 {
-    ui->lineEditPackage->setFocus();
-
-    packageList = getListFor(projectName);
-    QStringListModel *model = new QStringListModel(packageList);
-    packageCompleter = new QCompleter(model, this);
+    return getObsAccess()->getDataFileName(name + ".idx");
+}
 
-    ui->lineEditPackage->setCompleter(packageCompleter);
+bool RowEditor::isIndexUpToDate(const QString &name)
+{
+    QDir dataDir(OBSxmlReader::getDataDir());
+    QFileInfo listInfo(dataDir.filePath(getObsAccess()->getDataFileName(name + ".xml")));
+    QFileInfo indexInfo(dataDir.filePath(getIndexFileName(name)));
+    return listInfo.exists() && indexInfo.exists() &&
+            indexInfo.lastModified() >= listInfo.lastModified();
+}
 
-    connect(ui->lineEditPackage, SIGNAL(textEdited(const QString&)),
-            this, SLOT(refreshPackageAutocompleter(const QString&)));
-    connect(packageCompleter, SIGNAL(activated(const QString&)),
-            this, SLOT(autocompletedPackageName_clicked(const QString&)));
+OBSlistIndex *RowEditor::getIndexFor(const QString &name)
+{
+//    The listing is only parsed (and the index rebuilt) when it has
+//    changed, otherwise the index is just mapped into memory
+    QElapsedTimer timer;
+    timer.start();
+    QString indexName = getIndexFileName(name);
+
+    OBSlistIndex *index = new OBSlistIndex();
+    if (isIndexUpToDate(name) && index->open(indexName)) {
+        revalidate(name);
+    } else {
+        delete index;
+        OBSlistIndex::build(indexName, getListFor(name));
+        index = new OBSlistIndex();
+        index->open(indexName);
+    }
+    qDebug() << "Index for" << name << "opened in" << timer.elapsed() << "ms ("
+             << index->count() << "entries )";
+    return index;
 }
 
-void RowEditor::refreshPackageAutocompleter(const QString&)
+QCompleter *RowEditor::createCompleter(OBSlistModel *model, QLineEdit *lineEdit)
 {
-    QStringListModel *model = (QStringListModel*)(packageCompleter->model());
-    model->setStringList(packageList);
+//    The model already holds only the entries starting with the text
+//    (a binary search on the sorted index per keystroke), so
+//    QCompleter just shows them instead of filtering the whole list
+    QCompleter *completer = new QCompleter(model, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    lineEdit->setCompleter(completer);
+    connect(lineEdit, SIGNAL(textEdited(const QString&)), model, SLOT(setPrefix(const QString&)));
+    return completer;
 }
 
-void RowEditor::autocompletedPackageName_clicked(const QString&)
+void RowEditor::initAutocompleters()
 {
-    ui->lineEditRepository->setFocus();
+    projectModel = new OBSlistModel(this);
+    projectModel->setIndex(getIndexFor("projects"));
+    projectCompleter = createCompleter(projectModel, ui->lineEditProject);
+    connect(projectCompleter, SIGNAL(activated(const QString&)),
+            this, SLOT(autocompletedProjectName_clicked(const QString&)));
+
+//    Substring/fuzzy search, the index is built in the background
+    projectResults = new QStringListModel(this);
+    projectSearch = new OBSsearchIndex(this);
+    connect(projectSearch, SIGNAL(ready()), this, SLOT(projectSearchReady()));
+    connect(ui->lineEditProject, SIGNAL(textEdited(const QString&)),
+            this, SLOT(searchProjects(const QString&)));
+    projectSearch->build(getIndexFileName("projects"));
 
-    repositoryList = getListFor(ui->lineEditProject->text() + "_meta");
-    QStringListModel *model = new QStringListModel(repositoryList);
-    repositoryCompleter = new QCompleter(model, this);
+    packageModel = new OBSlistModel(this);
+    packageCompleter = createCompleter(packageModel, ui->lineEditPackage);
+    connect(packageCompleter, SIGNAL(activated(const QString&)),
+            this, SLOT(autocompletedPackageName_clicked(const QString&)));
 
-    ui->lineEditRepository->setCompleter(repositoryCompleter);
+    packageResults = new QStringListModel(this);
+    packageSearch = new OBSsearchIndex(this);
+    connect(packageSearch, SIGNAL(ready()), this, SLOT(packageSearchReady()));
+    connect(ui->lineEditPackage, SIGNAL(textEdited(const QString&)),
+            this, SLOT(searchPackages(const QString&)));
 
-    connect(ui->lineEditRepository, SIGNAL(textEdited(const QString&)),
-            this, SLOT(refreshRepositoryAutocompleter(const QString&)));
+    repositoryModel = new OBSlistModel(this);
+    repositoryCompleter = createCompleter(repositoryModel, ui->lineEditRepository);
     connect(repositoryCompleter, SIGNAL(activated(const QString&)),
             this, SLOT(autocompletedRepositoryName_clicked(const QString&)));
+
+    archModel = new OBSlistModel(this);
+    archCompleter = createCompleter(archModel, ui->lineEditArch);
 }
 
-void RowEditor::refreshRepositoryAutocompleter(const QString&)
+void RowEditor::autocompletedProjectName_clicked(const QString &projectName)
 {
-    QStringListModel *model = (QStringListModel*)(repositoryCompleter->model());
-    model->setStringList(repositoryList);
+    ui->lineEditPackage->setFocus();
+    packageModel->setIndex(getIndexFor(projectName));
+    packageModel->setPrefix(ui->lineEditPackage->text());
+    packageCompleter->setModel(packageModel);
+    packageSearch->build(getIndexFileName(projectName));
 }
 
-void RowEditor::autocompletedRepositoryName_clicked(const QString &repository)
+void RowEditor::autocompletedPackageName_clicked(const QString&)
 {
-    ui->lineEditArch->setFocus();
-
-    xmlReader->getArchsForRepository(repository);
-    archList = xmlReader->getList();
-    QStringListModel *model = new QStringListModel(archList);
-    archCompleter = new QCompleter(model, this);
-
-    ui->lineEditArch->setCompleter(archCompleter);
-
-    connect(ui->lineEditArch, SIGNAL(textEdited(const QString&)),
-            this, SLOT(refreshArchAutocompleter(const QString&)));
+    ui->lineEditRepository->setFocus();
+    repositoryModel->setList(getMetaFor(ui->lineEditProject->text()).getRepositories());
+    repositoryModel->setPrefix(ui->lineEditRepository->text());
 }
 
-void RowEditor::refreshArchAutocompleter(const QString&)
+void RowEditor::autocompletedRepositoryName_clicked(const QString &repository)
 {
-    QStringListModel *model = (QStringListModel*)(archCompleter->model());
-    model->setStringList(archList);
+    ui->lineEditArch->setFocus();
+    archModel->setList(getMetaFor(ui->lineEditProject->text()).getArchs(repository));
+    archModel->setPrefix(ui->lineEditArch->text());
 }
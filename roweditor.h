@@ -23,12 +23,16 @@
 
 #include <QDialog>
 #include <QCompleter>
+#include <QLineEdit>
 #include <QStringListModel>
-#include <QDate>
+#include <QHash>
 #include <QSettings>
 #include <QProgressDialog>
 #include "obsaccess.h"
 #include "obsxmlreader.h"
+#include "obslistindex.h"
+#include "obslistmodel.h"
+#include "obssearchindex.h"
 
 namespace Ui {
 class RowEditor;
@@ -49,31 +53,47 @@ public:
     void setPackage(const QString &);
     void setRepository(const QString &);
     void setArch(const QString &);
+    QString getApiUrl();
+    void setApiUrl(const QString &);
 
 private:
     Ui::RowEditor *ui;
-    QString getLastUpdateDate();
-    void setLastUpdateDate(const QString &date);
+    OBSaccess *getObsAccess();
     QStringList getListFor(const QString &name);
-    QStringList projectList;
+    QStringList downloadList(const QString &name);
+    OBSprojectMeta getMetaFor(const QString &project);
+    QHash<int, QString> revalidations;
+    void revalidate(const QString &name);
+    QString getIndexFileName(const QString &name);
+    bool isIndexUpToDate(const QString &name);
+    OBSlistIndex *getIndexFor(const QString &name);
+    OBSlistModel *projectModel;
     QCompleter *projectCompleter;
-    void initProjectAutocompleter();
-    QStringList packageList;
+    OBSlistModel *packageModel;
     QCompleter *packageCompleter;
-    QStringList repositoryList;
+    OBSlistModel *repositoryModel;
     QCompleter *repositoryCompleter;
-    QStringList archList;
+    OBSlistModel *archModel;
     QCompleter *archCompleter;
-    OBSxmlReader *xmlReader;
+    OBSsearchIndex *projectSearch;
+    QStringListModel *projectResults;
+    OBSsearchIndex *packageSearch;
+    QStringListModel *packageResults;
+    QCompleter *createCompleter(OBSlistModel *model, QLineEdit *lineEdit);
+    void updateCompleter(QCompleter *completer, OBSlistModel *model, OBSsearchIndex *search,
+                         QStringListModel *results, const QString &text);
+    void initAutocompleters();
 
 private slots:
-    void refreshProjectAutocompleter(const QString &);
+    void serverChanged();
+    void revalidationFinished(int requestId);
+    void projectSearchReady();
+    void searchProjects(const QString &text);
+    void packageSearchReady();
+    void searchPackages(const QString &text);
     void autocompletedProjectName_clicked(const QString &projectName);
-    void refreshPackageAutocompleter(const QString&);
     void autocompletedPackageName_clicked(const QString&);
-    void refreshRepositoryAutocompleter(const QString&);
     void autocompletedRepositoryName_clicked(const QString&repository);
-    void refreshArchAutocompleter(const QString&);
 };
 
 #endif // ROWEDITOR_H